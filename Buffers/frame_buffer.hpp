@@ -0,0 +1,74 @@
+#ifndef CGLABS__FRAME_BUFFER_HPP_
+#define CGLABS__FRAME_BUFFER_HPP_
+
+#include "../functions.hpp"
+#include "../gpu_memory.hpp"
+class FrameBuffer {
+  uint colorAttachment{};///< renderbuffer with RGBA8 color
+  uint depthAttachment{};///< renderbuffer with depth and stencil
+  glm::vec2 size{};
+
+ public:
+  uint rendererID{};
+  /**
+   * @brief Creates offscreen render target with color and depth attachments
+   * @param _size size of the render target in pixels
+   */
+  explicit FrameBuffer(glm::vec2 _size) {
+	size = _size;
+	glCall(glGenFramebuffers(1, &rendererID));
+	glCall(glBindFramebuffer(GL_FRAMEBUFFER, rendererID));
+
+	glCall(glGenRenderbuffers(1, &colorAttachment));
+	glCall(glBindRenderbuffer(GL_RENDERBUFFER, colorAttachment));
+	glCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, (GLsizei)size.x, (GLsizei)size.y));
+	glCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorAttachment));
+
+	glCall(glGenRenderbuffers(1, &depthAttachment));
+	glCall(glBindRenderbuffer(GL_RENDERBUFFER, depthAttachment));
+	glCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, (GLsizei)size.x, (GLsizei)size.y));
+	glCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthAttachment));
+
+	auto attachmentBytes = (size_t)size.x * (size_t)size.y * 4;
+	GpuMemory::track(GpuMemory::RENDERBUFFER, colorAttachment, attachmentBytes, "offscreen target");
+	GpuMemory::track(GpuMemory::RENDERBUFFER, depthAttachment, attachmentBytes, "offscreen target");
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+	  LOG_S(FATAL) << "FrameBuffer(" << rendererID << ") is incomplete";
+	  throw std::runtime_error("Failed to create framebuffer");
+	}
+	glCall(glViewport(0, 0, (GLsizei)size.x, (GLsizei)size.y));
+	LOG_S(INFO) << "FrameBuffer created rendererID: " << rendererID;
+  }
+  ~FrameBuffer() {
+	glCall(glDeleteRenderbuffers(1, &colorAttachment));
+	glCall(glDeleteRenderbuffers(1, &depthAttachment));
+	GpuMemory::release(GpuMemory::RENDERBUFFER, colorAttachment);
+	GpuMemory::release(GpuMemory::RENDERBUFFER, depthAttachment);
+	glCall(glDeleteFramebuffers(1, &rendererID));
+	LOG_S(INFO) << "FrameBuffer destroyed rendererID: " << rendererID;
+  }
+  void bind() const {
+	glCall(glBindFramebuffer(GL_FRAMEBUFFER, rendererID));
+  }
+  [[maybe_unused]] static void unbind() {
+	glCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+  }
+  [[nodiscard]] const glm::vec2 &getSize() const {
+	return size;
+  }
+  /**
+   * @brief reads color attachment back to CPU
+   * @return RGBA8 pixels, bottom row first
+   */
+  [[nodiscard]] std::vector<unsigned char> readPixels() const {
+	std::vector<unsigned char> pixels((size_t)size.x * (size_t)size.y * 4);
+	bind();
+	glCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
+	glCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	glCall(glReadPixels(0, 0, (GLsizei)size.x, (GLsizei)size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	return pixels;
+  }
+};
+
+#endif//CGLABS__FRAME_BUFFER_HPP_
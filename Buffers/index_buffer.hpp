@@ -5,8 +5,11 @@
 #ifndef CGLABS__INDEX_BUFFER_HPP_
 #define CGLABS__INDEX_BUFFER_HPP_
 
+#include <algorithm>
+
 #include "../buffer.hpp"
 #include "../functions.hpp"
+#include "../gpu_memory.hpp"
 class IndexBuffer {
 
  public:
@@ -15,10 +18,30 @@ class IndexBuffer {
    * @param points std::vector<float>
    */
    uint rendererID{};
+  GLenum type{GL_UNSIGNED_INT};///< GL_UNSIGNED_SHORT when every index fits in 16 bits
+  unsigned long length{0};
+  /**
+   * @brief uploads indices, as 16 bit values if they fit
+   */
   explicit IndexBuffer(const std::vector<unsigned int>& indices){
+	length = indices.size();
 	glCall(glGenBuffers(1, &rendererID));
 	glCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID));
-	glCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW));
+	if (!indices.empty() && *std::max_element(indices.begin(), indices.end()) <= 0xFFFF) {
+	  type = GL_UNSIGNED_SHORT;
+	  std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+	  glCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW));
+	  GpuMemory::track(GpuMemory::INDEX_BUFFER, rendererID, shortIndices.size() * sizeof(unsigned short));
+	} else {
+	  glCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW));
+	  GpuMemory::track(GpuMemory::INDEX_BUFFER, rendererID, indices.size() * sizeof(unsigned int));
+	}
+  }
+  [[nodiscard]] GLenum getType() const {
+	return type;
+  }
+  [[nodiscard]] unsigned long getLength() const {
+	return length;
   }
   void bind() const {
 	glCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID));
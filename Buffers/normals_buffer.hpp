@@ -16,10 +16,27 @@ class NormalsBuffer : public Buffer {
   explicit NormalsBuffer(std::vector<float> points) : Buffer(std::move(points)) {
 	bufferType = Buffer::type::NORMAL;
 	attributeLocation=3;
+	layout.push<float>(3);
   }
   explicit NormalsBuffer(std::vector<glm::vec3> coordinates) : Buffer(std::move(vec3ArrayToFloatArray(std::move(coordinates)))) {
 	bufferType = Buffer::type::NORMAL;
 	attributeLocation=3;
+	layout.push<float>(3);
+  }
+  /**
+   * @brief normals from VertexPacking::packNormals(), 10 bits per component
+   */
+  explicit NormalsBuffer(const std::vector<uint32_t> &packed)
+	  : Buffer(packed.data(), packed.size() * sizeof(uint32_t), packedLayout()) {
+	bufferType = Buffer::type::NORMAL;
+	attributeLocation=3;
+  }
+
+ private:
+  static VertexBufferLayout packedLayout() {
+	VertexBufferLayout result;
+	result.push(GL_INT_2_10_10_10_REV, 4, true);
+	return result;
   }
 };
 
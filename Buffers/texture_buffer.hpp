@@ -16,10 +16,27 @@ class TextureBuffer : public Buffer {
   explicit TextureBuffer(std::vector<float> points) : Buffer(std::move(points)) {
 	bufferType = Buffer::type::TEXTURE_COORDS;
 	attributeLocation=2;
+	layout.push<float>(2);
   }
   explicit TextureBuffer(std::vector<glm::vec3> coordinates) : Buffer(std::move(vec3ArrayToFloatArray(std::move(coordinates)))) {
 	bufferType = Buffer::type::TEXTURE_COORDS;
 	attributeLocation=2;
+	layout.push<float>(2);
+  }
+  /**
+   * @brief texture coordinates from VertexPacking::packTexCoords(), two half floats or normalized shorts per vertex
+   */
+  TextureBuffer(const std::vector<uint32_t> &packed, bool normalized)
+	  : Buffer(packed.data(), packed.size() * sizeof(uint32_t), packedLayout(normalized)) {
+	bufferType = Buffer::type::TEXTURE_COORDS;
+	attributeLocation=2;
+  }
+
+ private:
+  static VertexBufferLayout packedLayout(bool normalized) {
+	VertexBufferLayout result;
+	result.push(normalized ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT, 2, normalized);
+	return result;
   }
 };
 
@@ -6,6 +6,7 @@
 #define CGLABS__VERTEX_ARRAY_HPP_
 
 #include "../functions.hpp"
+#include "../render_stats.hpp"
 #include "vertex_buffer.hpp"
 #include "vertex_buffer_layout.hpp"
 class VertexArray {
@@ -23,6 +24,7 @@ class VertexArray {
   }
   void bind() const {
 	glCall(glBindVertexArray(rendererID));
+	RenderStats::current().vertexArrayBinds++;
   }
   [[maybe_unused]] static void unbind() {
 	glCall(glBindVertexArray(0));
@@ -38,7 +40,7 @@ class VertexArray {
 	for (auto element : elements) {
 	  glCall(glVertexAttribPointer(vertexAttribIndex, element.length, element.type, element.normalized,
 								   layout.getStride(), (const void *)offset));
-	  offset += element.length * VertexBufferElement::getSize(element.type);
+	  offset += element.getBytes();
 	}
 	glCall(glEnableVertexAttribArray(vertexAttribIndex));
   }
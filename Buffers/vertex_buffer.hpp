@@ -17,9 +17,25 @@ class VertexBuffer : public Buffer {
    */
   explicit VertexBuffer(std::vector<float> points) : Buffer(std::move(points)) {
 	bufferType = Buffer::type::VERTEX;
+	layout.push<float>(3);
   }
   explicit VertexBuffer(std::vector<glm::vec3> coordinates) : Buffer(std::move(vec3ArrayToFloatArray(std::move(coordinates)))) {
 	bufferType = Buffer::type::VERTEX;
+	layout.push<float>(3);
+  }
+  /**
+   * @brief positions from VertexPacking::quantizePositions(), 4 normalized shorts per vertex
+   */
+  explicit VertexBuffer(const std::vector<uint16_t> &quantized)
+	  : Buffer(quantized.data(), quantized.size() * sizeof(uint16_t), quantizedLayout()) {
+	bufferType = Buffer::type::VERTEX;
+  }
+
+ private:
+  static VertexBufferLayout quantizedLayout() {
+	VertexBufferLayout result;
+	result.push(GL_UNSIGNED_SHORT, 4, true);
+	return result;
   }
 };
 
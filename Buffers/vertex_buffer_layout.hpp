@@ -7,6 +7,8 @@
 
 #include <vector>
 
+#include <glad/glad.h>
+
 struct VertexBufferElement {
   unsigned int type;
   unsigned int length;
@@ -16,10 +18,20 @@ struct VertexBufferElement {
 	switch (type) {
 	  case GL_FLOAT:
 	  case GL_UNSIGNED_INT: return 4;
+	  case GL_HALF_FLOAT:
+	  case GL_SHORT:
+	  case GL_UNSIGNED_SHORT: return 2;
 	  case GL_UNSIGNED_BYTE: return 1;
 	  default: return -1;
 	}
   }
+  /**
+   * @brief bytes one vertex takes, all components of packed types share 4 bytes
+   */
+  [[nodiscard]] unsigned int getBytes() const {
+	if (type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV) return 4;
+	return length * getSize(type);
+  }
 };
 class VertexBufferLayout {
   std::vector<VertexBufferElement> elements;
@@ -35,6 +47,14 @@ class VertexBufferLayout {
   template<typename T>
   void push([[maybe_unused]] unsigned int length) {
   }
+  /**
+   * @brief adds attribute of any GL type, also ones C++ has no type for (GL_HALF_FLOAT, GL_INT_2_10_10_10_REV)
+   * @param normalized integers are read as [0, 1] (unsigned) or [-1, 1] (signed) floats
+   */
+  void push(unsigned int type, unsigned int length, bool normalized) {
+	elements.push_back({type, length, (unsigned char)(normalized ? GL_TRUE : GL_FALSE)});
+	stride += elements.back().getBytes();
+  }
 
 };
 template<>
@@ -48,6 +68,16 @@ void VertexBufferLayout::push<unsigned int>(unsigned int length) {
   stride += length * VertexBufferElement::getSize(GL_UNSIGNED_INT);
 }
 template<>
+void VertexBufferLayout::push<unsigned short>(unsigned int length) {
+  elements.push_back({GL_UNSIGNED_SHORT, length, GL_FALSE});
+  stride += length * VertexBufferElement::getSize(GL_UNSIGNED_SHORT);
+}
+template<>
+void VertexBufferLayout::push<short>(unsigned int length) {
+  elements.push_back({GL_SHORT, length, GL_FALSE});
+  stride += length * VertexBufferElement::getSize(GL_SHORT);
+}
+template<>
 void VertexBufferLayout::push<unsigned char>(unsigned int length) {
   elements.push_back({GL_UNSIGNED_BYTE, length, GL_FALSE});
   stride += length * VertexBufferElement::getSize(GL_UNSIGNED_BYTE);
@@ -7,6 +7,7 @@
 
 #include <map>
 
+#include "gl_debug.hpp"
 #include "window.hpp"
 
 class Application {
@@ -21,12 +22,16 @@ class Application {
    * @brief initialises application
    * @param windowSize glm::vec2 window size
    * @param argc used by logging lib
-   * @param argv used by logging lib
+   * @param argv used by logging lib; "--headless" makes window render offscreen,
+   * "--gl-debug-severity <high|medium|low|notification>" sets minimal severity of logged driver messages
    */
   void init(glm::vec2 windowSize, [[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
 	LOG_S(INFO) << "Hello world!";
 	logInit(argc, argv);
-	window = new Window(windowSize);
+	window = new Window(windowSize, isFlagPresent(argc, argv, "--headless"));
+	GlDebug::Settings debugSettings;
+	debugSettings.minSeverity = GlDebug::severityFromString(getFlagValue(argc, argv, "--gl-debug-severity", "low"));
+	GlDebug::install(debugSettings);
 	setOpenGLFlags();
 	/// following is required for keyboard related callbacks
 	glfwSetKeyCallback(window->getGLFWWindow(), keyCallback);
@@ -89,6 +94,7 @@ class Application {
    */
   void close() {
 	shouldClose = true;
+	GlDebug::shutdown();
 	delete (window);
   }
 
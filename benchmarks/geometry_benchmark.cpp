@@ -0,0 +1,148 @@
+// Microbenchmarks for CPU-side geometry helpers. Nothing here creates GL context or calls GL.
+// Usage: vlBenchmark [--size <triangles>] [--filter <substring>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../libs/stb_image.h"
+#include "../mesh.hpp"
+
+static volatile size_t sink;///< results are written here so compiler can't throw benchmarked code away
+
+/**
+ * @brief runs function repeatedly for ~0.5s (at least 5 times) and prints median and min time
+ * @param name benchmark name
+ * @param items amount of elements processed by one call, used for ns/item
+ * @param func benchmarked function, should return something with size()
+ */
+template<typename Func>
+void runBenchmark(const std::string &name, const std::string &filter, size_t items, Func &&func) {
+  if (!filter.empty() && name.find(filter) == std::string::npos) return;
+  using clock = std::chrono::steady_clock;
+  sink = sink + func().size();// warm up
+  std::vector<double> samples;
+  auto started = clock::now();
+  while (samples.size() < 5 || (clock::now() - started < std::chrono::milliseconds(500) && samples.size() < 1000)) {
+	auto start = clock::now();
+	sink = sink + func().size();
+	samples.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+  }
+  std::sort(samples.begin(), samples.end());
+  double median = samples[samples.size() / 2];
+  printf("%-40s %10zu items %6zu runs  median %9.3f ms  min %9.3f ms  %8.2f ns/item\n", name.c_str(), items,
+		 samples.size(), median, samples.front(), median * 1e6 / (double)items);
+}
+
+/**
+ * @brief builds aiMesh with given amount of independent triangles, every vertex has normal and uv
+ */
+aiMesh *makeMesh(size_t triangles, std::mt19937 &gen) {
+  std::uniform_real_distribution<float> dist(-10.f, 10.f);
+  auto *mesh = new aiMesh;
+  mesh->mNumVertices = (unsigned int)(triangles * 3);
+  mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+  mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+  mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+  mesh->mNumUVComponents[0] = 2;
+  for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+	mesh->mVertices[i] = aiVector3D(dist(gen), dist(gen), dist(gen));
+	mesh->mNormals[i] = aiVector3D(0, 1, 0);
+	mesh->mTextureCoords[0][i] = aiVector3D(dist(gen), dist(gen), 0);
+  }
+  mesh->mNumFaces = (unsigned int)triangles;
+  mesh->mFaces = new aiFace[mesh->mNumFaces];
+  for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+	mesh->mFaces[i].mNumIndices = 3;
+	mesh->mFaces[i].mIndices = new unsigned int[3]{i * 3, i * 3 + 1, i * 3 + 2};
+  }
+  return mesh;
+}
+
+/**
+ * @brief indexed grid with about given amount of triangles, rows are shuffled so vertex cache order matters
+ */
+ObjLoader::loadedOBJ makeGrid(size_t triangles, std::mt19937 &gen) {
+  auto side = (uint)std::max(1.0, std::sqrt((double)triangles / 2));
+  ObjLoader::loadedOBJ grid;
+  for (uint y = 0; y <= side; ++y) {
+	for (uint x = 0; x <= side; ++x) grid.vertices.insert(grid.vertices.end(), {(float)x, 0, (float)y});
+  }
+  std::vector<uint> rows(side);
+  std::iota(rows.begin(), rows.end(), 0);
+  std::shuffle(rows.begin(), rows.end(), gen);
+  for (auto y : rows) {
+	for (uint x = 0; x < side; ++x) {
+	  uint corner = y * (side + 1) + x;
+	  grid.indices.insert(grid.indices.end(), {corner, corner + side + 1, corner + 1, corner + 1, corner + side + 1, corner + side + 2});
+	}
+  }
+  return grid;
+}
+
+int main(int argc, char *argv[]) {
+  size_t triangles = std::stoul(getFlagValue(argc, argv, "--size", "1000000"));
+  std::string filter = getFlagValue(argc, argv, "--filter");
+  size_t vertexCount = triangles * 3;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-10.f, 10.f);
+  std::vector<float> coordinates(vertexCount * 3);
+  for (auto &coordinate : coordinates) coordinate = dist(gen);
+  auto vec3s = floatArrayToVec3Array(coordinates);
+  auto *mesh = makeMesh(triangles, gen);
+
+  printf("vlBenchmark: %zu triangles (%zu vertices)\n", triangles, vertexCount);
+  runBenchmark("floatArrayToVec3Array", filter, vertexCount, [&] {
+	return floatArrayToVec3Array(coordinates);
+  });
+  runBenchmark("vec3ArrayToFloatArray", filter, vertexCount, [&] {
+	return vec3ArrayToFloatArray(vec3s);
+  });
+  runBenchmark("Texture::generateTextureCoords", filter, vertexCount, [&] {
+	return Texture::generateTextureCoords(vertexCount, {2, 3});
+  });
+  runBenchmark("Mesh::calculateNormal", filter, triangles, [&] {
+	std::vector<glm::vec3> normals(triangles);
+	for (size_t i = 0; i < triangles; ++i) {
+	  normals[i] = Mesh::calculateNormal(vec3s[i * 3], vec3s[i * 3 + 1], vec3s[i * 3 + 2]);
+	}
+	return normals;
+  });
+  runBenchmark("Mesh::calculateNormals", filter, vertexCount, [&] {
+	return Mesh::calculateNormals(coordinates);
+  });
+  size_t models = 100000;
+  runBenchmark("Mesh::calculateModel", filter, models, [&] {
+	std::vector<glm::mat4> matrices(models);
+	for (size_t i = 0; i < models; ++i) {
+	  auto f = (float)i;
+	  matrices[i] = Mesh::calculateModel({f, 0.5f, -f}, {f, 0, 0}, {270, f, 180}, {0.5f, 0.5f, 0.5f});
+	}
+	return matrices;
+  });
+  runBenchmark("ObjLoader::flattenMesh", filter, vertexCount, [&] {
+	return ObjLoader::flattenMesh(mesh).vertices;
+  });
+  runBenchmark("ObjLoader::indexMesh", filter, vertexCount, [&] {
+	return ObjLoader::indexMesh(mesh).vertices;
+  });
+
+  auto grid = makeGrid(triangles, gen);
+  runBenchmark("MeshOptimizer::optimizeVertexCache", filter, grid.indices.size() / 3, [&] {
+	return MeshOptimizer::optimizeVertexCache(grid.indices, grid.vertices.size() / 3);
+  });
+  runBenchmark("MeshOptimizer::optimizeOverdraw", filter, grid.indices.size() / 3, [&] {
+	return MeshOptimizer::optimizeOverdraw(grid.indices, grid.vertices);
+  });
+  runBenchmark("MeshSimplifier::simplify", filter, grid.indices.size() / 3, [&] {
+	return MeshSimplifier::simplify(grid.indices, grid.vertices, grid.indices.size() / 4, INFINITY);
+  });
+
+  delete mesh;
+  return 0;
+}
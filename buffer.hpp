@@ -5,7 +5,9 @@
 #ifndef CGLABS__BUFFER_HPP_
 #define CGLABS__BUFFER_HPP_
 
+#include "Buffers/vertex_buffer_layout.hpp"
 #include "functions.hpp"
+#include "gpu_memory.hpp"
 class Buffer {
  public:
   enum type {
@@ -29,15 +31,28 @@ class Buffer {
 	glGenBuffers(1, &rendererID);
 	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
 	glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(float), points.data(), GL_STATIC_DRAW);
+	GpuMemory::track(GpuMemory::BUFFER, rendererID, points.size() * sizeof(float));
   }
   Buffer(std::vector<float> points, int attributePosition) {
 	glGenBuffers(1, &rendererID);
 	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
 	glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(float), points.data(), GL_STATIC_DRAW);
+	GpuMemory::track(GpuMemory::BUFFER, rendererID, points.size() * sizeof(float));
 	attributeLocation = attributePosition;
   }
+  /**
+   * @brief uploads vertex data in any format
+   * @param _layout how data is stored, one attribute per buffer
+   */
+  Buffer(const void *data, size_t bytes, VertexBufferLayout _layout) : layout(std::move(_layout)) {
+	glGenBuffers(1, &rendererID);
+	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, data, GL_STATIC_DRAW);
+	GpuMemory::track(GpuMemory::BUFFER, rendererID, bytes);
+  }
   type bufferType{OTHER};
   int attributeLocation{0};
+  VertexBufferLayout layout;///< format of the attribute, set by typed buffers
 };
 
 #endif//CGLABS__BUFFER_HPP_
\ No newline at end of file
@@ -125,6 +125,12 @@ class Camera {
 	shader->setUniformMat4f("model", model);
 	shader->setUniform3f("viewPos", Position);
   }
+  // sets Euler angles directly, used when camera is driven by a CameraPath instead of the mouse
+  void setOrientation(float yaw, float pitch) {
+	Yaw = yaw;
+	Pitch = pitch;
+	updateCameraVectors();
+  }
   void setWindowSize(glm::vec2 _windowSize) {
 	windowSize = _windowSize;
   }
@@ -0,0 +1,117 @@
+#ifndef CGCOURSEWORK_CAMERA_PATH_HPP
+#define CGCOURSEWORK_CAMERA_PATH_HPP
+
+#include <fstream>
+#include <sstream>
+
+#include "camera.hpp"
+
+/**
+ * @brief list of camera poses that can be recorded, saved to file and replayed
+ * @details file format is plain text, one keyframe per line: "x y z yaw pitch", lines starting with # are ignored
+ */
+class CameraPath {
+ public:
+  struct Keyframe {
+	glm::vec3 position{};
+	float yaw{YAW};
+	float pitch{PITCH};
+  };
+
+ private:
+  std::vector<Keyframe> keyframes{};
+
+ public:
+  CameraPath() = default;
+
+  /**
+   * @brief loads camera path from file
+   * @param filepath path to file with keyframes
+   */
+  explicit CameraPath(const std::string &filepath) {
+	std::ifstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(FATAL) << "Unable to open camera path at: " << filepath;
+	  throw std::runtime_error("Unable to open camera path");
+	}
+	std::string line;
+	while (std::getline(stream, line)) {
+	  if (line.empty() || line[0] == '#') continue;
+	  std::istringstream ss(line);
+	  Keyframe keyframe;
+	  if (ss >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.yaw >> keyframe.pitch) {
+		keyframes.push_back(keyframe);
+	  } else {
+		LOG_S(WARNING) << "Skipping malformed camera path line: " << line;
+	  }
+	}
+	LOG_S(INFO) << "Loaded camera path with " << keyframes.size() << " keyframes from " << filepath;
+  }
+
+  /**
+   * @brief path that walks around the level between inner rooms and outer walls
+   * @return scripted CameraPath
+   */
+  static CameraPath scripted() {
+	CameraPath path;
+	path.keyframes = {
+		{{3, 1, 3}, -90, 0},
+		{{3, 1, -14.5}, -90, -10},
+		{{3, 1, -14.5}, -180, 0},
+		{{-39.5, 1, -14.5}, -180, 10},
+		{{-39.5, 1, -14.5}, -270, 0},
+		{{-39.5, 1, 3}, -270, -10},
+		{{-39.5, 1, 3}, -360, 0},
+		{{3, 1, 3}, -360, 0},
+	};
+	return path;
+  }
+
+  /**
+   * @brief appends current camera pose
+   * @param camera camera to take pose from
+   */
+  void addKeyframe(const Camera &camera) {
+	keyframes.push_back({camera.Position, camera.Yaw, camera.Pitch});
+  }
+
+  /**
+   * @brief saves keyframes in the same format constructor reads
+   * @param filepath where to save
+   */
+  void save(const std::string &filepath) const {
+	std::ofstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to save camera path to: " << filepath;
+	  return;
+	}
+	stream << "# x y z yaw pitch\n";
+	for (auto &keyframe : keyframes) {
+	  stream << keyframe.position.x << " " << keyframe.position.y << " " << keyframe.position.z << " "
+			 << keyframe.yaw << " " << keyframe.pitch << "\n";
+	}
+	LOG_S(INFO) << "Saved camera path with " << keyframes.size() << " keyframes to " << filepath;
+  }
+
+  /**
+   * @brief moves camera to a point on the path
+   * @param camera camera to move
+   * @param t position on the path, 0 is first keyframe, 1 is last
+   */
+  void apply(Camera *camera, double t) const {
+	if (keyframes.empty()) return;
+	double scaled = glm::clamp(t, 0.0, 1.0) * (double)(keyframes.size() - 1);
+	auto index = (size_t)scaled;
+	auto &from = keyframes[index];
+	auto &to = keyframes[std::min(index + 1, keyframes.size() - 1)];
+	auto alpha = (float)(scaled - (double)index);
+	camera->Position = glm::mix(from.position, to.position, alpha);
+	camera->setOrientation(glm::mix(from.yaw, to.yaw, alpha), glm::mix(from.pitch, to.pitch, alpha));
+  }
+
+  [[nodiscard]] size_t size() const {
+	return keyframes.size();
+  }
+};
+
+#endif//CGCOURSEWORK_CAMERA_PATH_HPP
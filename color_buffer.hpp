@@ -16,10 +16,12 @@ class ColorBuffer : public Buffer {
   explicit ColorBuffer(std::vector<float> points) : Buffer(std::move(points)) {
 	bufferType = Buffer::type::COLOR;
 	attributeLocation=1;
+	layout.push<float>(3);
   }
   explicit ColorBuffer(std::vector<glm::vec3> coordinates) : Buffer(std::move(vec3ArrayToFloatArray(std::move(coordinates)))) {
 	bufferType = Buffer::type::COLOR;
 	attributeLocation=1;
+	layout.push<float>(3);
   }
 };
 
@@ -0,0 +1,158 @@
+#ifndef CGCOURSEWORK_CPU_PROFILER_HPP
+#define CGCOURSEWORK_CPU_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "functions.hpp"
+
+#define CPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_INNER(a, b)
+/**
+ * @brief measures time until the end of current scope
+ * @param name string literal, it is stored by pointer
+ **/
+#define CPU_PROFILE_ZONE(name) CpuProfiler::Zone CPU_PROFILE_CONCAT(cpuProfileZone, __LINE__)(name)
+
+/**
+ * @brief records named CPU time zones and exports them as Chrome trace_event JSON (chrome://tracing, Perfetto)
+ * @details every thread writes to its own ring buffer, writing a zone takes no locks.
+ * When a ring buffer is full the oldest zones of that thread are overwritten.
+ */
+class CpuProfiler {
+ public:
+  struct Event {
+	const char *name{nullptr};
+	int64_t start{0};   ///< nanoseconds since profiler epoch
+	int64_t duration{0};///< nanoseconds
+  };
+
+ private:
+  static constexpr size_t ringCapacity = 1 << 16;///< zones kept per thread
+  struct ThreadBuffer {
+	std::unique_ptr<Event[]> events{new Event[ringCapacity]};
+	std::atomic<uint64_t> head{0};///< total amount of zones ever written by owning thread
+	int threadId{0};
+	bool isMainThread{false};
+  };
+
+  static std::atomic<bool> &enabledFlag() {
+	static std::atomic<bool> enabled{false};
+	return enabled;
+  }
+  static std::chrono::steady_clock::time_point epoch() {
+	static const auto start = std::chrono::steady_clock::now();
+	return start;
+  }
+  /// thread that called enable(), it is named "main" in exported trace
+  static std::thread::id &mainThread() {
+	static std::thread::id id;
+	return id;
+  }
+  static std::mutex &registryMutex() {
+	static std::mutex mutex;
+	return mutex;
+  }
+  /// buffers are never freed, so zones of finished threads can still be exported
+  static std::vector<ThreadBuffer *> &registry() {
+	static std::vector<ThreadBuffer *> buffers;
+	return buffers;
+  }
+  static ThreadBuffer &localBuffer() {
+	thread_local ThreadBuffer *buffer = [] {
+	  auto *newBuffer = new ThreadBuffer;
+	  std::lock_guard<std::mutex> lock(registryMutex());
+	  newBuffer->threadId = (int)registry().size();
+	  newBuffer->isMainThread = std::this_thread::get_id() == mainThread();
+	  registry().push_back(newBuffer);
+	  return newBuffer;
+	}();
+	return *buffer;
+  }
+
+ public:
+  /**
+   * @brief RAII zone, use CPU_PROFILE_ZONE() macro instead of creating it directly
+   */
+  class Zone {
+	const char *name;
+	int64_t start{-1};
+
+   public:
+	explicit Zone(const char *_name) : name(_name) {
+	  if (isEnabled()) start = now();
+	}
+	~Zone() {
+	  if (start >= 0) record(name, start, now() - start);
+	}
+	Zone(const Zone &) = delete;
+	Zone &operator=(const Zone &) = delete;
+  };
+
+  static void enable(bool enabled = true) {
+	epoch();
+	mainThread() = std::this_thread::get_id();
+	enabledFlag().store(enabled, std::memory_order_relaxed);
+  }
+  [[nodiscard]] static bool isEnabled() {
+	return enabledFlag().load(std::memory_order_relaxed);
+  }
+  /**
+   * @brief current time
+   * @return nanoseconds since profiler epoch
+   */
+  static int64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count();
+  }
+
+  /**
+   * @brief stores finished zone in the ring buffer of calling thread
+   */
+  static void record(const char *name, int64_t start, int64_t duration) {
+	auto &buffer = localBuffer();
+	uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	buffer.events[head % ringCapacity] = {name, start, duration};
+	buffer.head.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief writes every zone that is still in ring buffers as Chrome trace_event JSON
+   * @param filepath where to write trace
+   * @return true on success
+   */
+  static bool exportChromeTrace(const std::string &filepath) {
+	std::ofstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to write CPU trace to: " << filepath;
+	  return false;
+	}
+	size_t written = 0;
+	stream << std::fixed << std::setprecision(3);
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	std::lock_guard<std::mutex> lock(registryMutex());
+	for (auto *buffer : registry()) {
+	  stream << (written == 0 ? "" : ",\n")
+			 << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->threadId
+			 << R"(,"args":{"name":")" << (buffer->isMainThread ? "main" : "worker " + std::to_string(buffer->threadId)) << "\"}}";
+	  written++;
+	  uint64_t head = buffer->head.load(std::memory_order_acquire);
+	  uint64_t first = head > ringCapacity ? head - ringCapacity : 0;
+	  for (uint64_t i = first; i < head; ++i) {
+		auto &event = buffer->events[i % ringCapacity];
+		stream << ",\n{\"name\":\"" << event.name << R"(","ph":"X","pid":1,"tid":)" << buffer->threadId
+			   << ",\"ts\":" << (double)event.start / 1000.0 << ",\"dur\":" << (double)event.duration / 1000.0 << "}";
+		written++;
+	  }
+	}
+	stream << "\n]}\n";
+	LOG_S(INFO) << "CPU trace with " << written << " events written to: " << filepath;
+	return true;
+  }
+};
+
+#endif//CGCOURSEWORK_CPU_PROFILER_HPP
@@ -6,9 +6,13 @@
 #define CGCOURSEWORK_CUBE_MAP_TEXTURE_HPP
 
 
+#include <filesystem>
 #include <iostream>
+#include "gpu_memory.hpp"
+#include "startup_timer.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "libs/stb_image.h"
+#include "texture.hpp"
 class CubeMapTexture {
 
 public:
@@ -18,13 +22,29 @@ public:
         glGenTextures(1, &textureID);
         glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
+        if (loadCooked(faces, textureID)) return textureID;
         int width, height, nrChannels;
+        size_t bytes = 0;
+        // faces were always loaded flipped, because Texture used to set the flag globally before skybox was loaded
+        stbi_set_flip_vertically_on_load_thread(1);
         for (unsigned int i = 0; i < faces.size(); i++)
         {
-            unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+            std::vector<unsigned char> file;
+            {
+                StartupTimer::Scope timer(faces[i], StartupTimer::READ);
+                file = readBinaryFile(faces[i]);
+            }
+            unsigned char *data = nullptr;
+            if (!file.empty())
+            {
+                StartupTimer::Scope timer(faces[i], StartupTimer::DECODE);
+                data = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &nrChannels, 0);
+            }
             if (data)
             {
+                StartupTimer::Scope timer(faces[i], StartupTimer::UPLOAD);
                 glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+                bytes += GpuMemory::textureBytes(width, height, 4, false);
                 stbi_image_free(data);
             }
             else
@@ -38,9 +58,45 @@ public:
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        GpuMemory::track(GpuMemory::CUBE_MAP, textureID, bytes, faces.empty() ? "cubemap" : std::filesystem::path(faces.front()).parent_path().string());
 
         return textureID;
     }
+
+private:
+    /**
+     * @brief uploads cooked faces to bound cube map
+     * @return false if any face isn't cooked, then nothing is uploaded
+     */
+    static bool loadCooked(const std::vector<std::string> &faces, unsigned int textureID)
+    {
+        if (faces.empty()) return false;
+        std::vector<KtxFile> cooked(faces.size());
+        for (unsigned int i = 0; i < faces.size(); i++)
+        {
+            if (!Texture::readCooked(faces[i], cooked[i])) return false;
+        }
+        size_t bytes = 0;
+        for (unsigned int i = 0; i < faces.size(); i++)
+        {
+            StartupTimer::Scope timer(faces[i], StartupTimer::UPLOAD);
+            for (size_t level = 0; level < cooked[i].levels.size(); level++)
+            {
+                auto &image = cooked[i].levels[level];
+                glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, (GLint)level, cooked[i].internalFormat, image.width, image.height, 0,
+                                       (GLsizei)image.size, cooked[i].data.data() + image.offset);
+            }
+            bytes += cooked[i].data.size();
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (GLint)cooked[0].levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        GpuMemory::track(GpuMemory::CUBE_MAP, textureID, bytes, std::filesystem::path(faces.front()).parent_path().string());
+        return true;
+    }
 };
 
 
@@ -0,0 +1,137 @@
+#ifndef CGCOURSEWORK_FRAME_PACER_HPP
+#define CGCOURSEWORK_FRAME_PACER_HPP
+
+#include <chrono>
+#include <thread>
+
+#include "cpu_profiler.hpp"
+#include "functions.hpp"
+
+/**
+ * @brief limits frame rate without keeping a core busy
+ * @details in CAPPED mode the thread sleeps until shortly before the deadline and yields for the rest,
+ * so the deadline is hit precisely even though sleep can oversleep by the OS timer resolution.
+ */
+class FramePacer {
+ public:
+  enum Mode {
+	VSYNC,   ///< swap waits for vertical blank
+	CAPPED,  ///< swap doesn't wait, frame rate is limited by sleeping
+	UNCAPPED ///< as fast as possible
+  };
+
+ private:
+  using clock = std::chrono::steady_clock;
+  Mode mode{CAPPED};
+  clock::duration period{};
+  clock::time_point deadline{};
+  clock::duration sleepMargin{std::chrono::milliseconds(2)};///< sleeping stops this long before deadline
+
+ public:
+  /**
+   * @param _mode how frame rate is limited
+   * @param targetFps frame rate in CAPPED mode
+   */
+  FramePacer(Mode _mode, double targetFps) {
+	mode = _mode;
+	period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / std::max(1.0, targetFps)));
+	deadline = clock::now() + period;
+  }
+
+  /**
+   * @brief sets swap interval of current context according to mode
+   */
+  void apply() const {
+	glfwSwapInterval(mode == VSYNC ? 1 : 0);
+	LOG_S(INFO) << "Frame pacing: " << modeToString(mode)
+				<< (mode == CAPPED ? " at " + std::to_string(1.0 / std::chrono::duration<double>(period).count()) + " fps" : "");
+  }
+
+  /**
+   * @brief waits until it is time to start next frame, call it once per frame
+   */
+  void wait() {
+	if (mode != CAPPED) return;
+	CPU_PROFILE_ZONE("FramePacer::wait");
+	auto now = clock::now();
+	if (now > deadline + period) {
+	  deadline = now;// we are more than a frame late, don't try to catch up with a burst of frames
+	} else {
+	  if (deadline - now > sleepMargin) std::this_thread::sleep_for(deadline - now - sleepMargin);
+	  while (clock::now() < deadline) std::this_thread::yield();
+	}
+	deadline += period;
+  }
+
+  [[nodiscard]] Mode getMode() const {
+	return mode;
+  }
+
+  /**
+   * @brief parses mode name used on command line: vsync, capped or uncapped
+   */
+  static Mode modeFromString(const std::string &name) {
+	if (name == "vsync") return VSYNC;
+	if (name == "uncapped") return UNCAPPED;
+	return CAPPED;
+  }
+
+  static std::string modeToString(Mode mode) {
+	switch (mode) {
+	  case VSYNC: return "vsync";
+	  case UNCAPPED: return "uncapped";
+	  default: return "capped";
+	}
+  }
+};
+
+/**
+ * @brief runs simulation in fixed steps independent from frame rate
+ * @details after advance() rendering should interpolate between previous and current simulation state with alpha()
+ */
+class FixedTimestep {
+  double step;
+  double accumulator{0};
+  int maxStepsPerFrame;
+
+ public:
+  /**
+   * @param stepsPerSecond simulation rate
+   * @param _maxStepsPerFrame after a long hitch time over this many steps is dropped instead of simulated
+   */
+  explicit FixedTimestep(double stepsPerSecond, int _maxStepsPerFrame = 8) {
+	step = 1.0 / std::max(1.0, stepsPerSecond);
+	maxStepsPerFrame = _maxStepsPerFrame;
+  }
+
+  /**
+   * @brief calls update(step) for every whole step that fits in elapsed time
+   * @param frameTime seconds since previous call
+   * @return amount of steps that were simulated
+   */
+  template<typename Update>
+  int advance(double frameTime, Update &&update) {
+	accumulator += std::max(0.0, frameTime);
+	int steps = 0;
+	while (accumulator >= step && steps < maxStepsPerFrame) {
+	  update(step);
+	  accumulator -= step;
+	  steps++;
+	}
+	if (steps == maxStepsPerFrame) accumulator = std::min(accumulator, step);
+	return steps;
+  }
+
+  /**
+   * @brief how far between previous and current simulation state the rendered frame is, 0..1
+   */
+  [[nodiscard]] double alpha() const {
+	return std::min(1.0, accumulator / step);
+  }
+
+  [[nodiscard]] double getStep() const {
+	return step;
+  }
+};
+
+#endif//CGCOURSEWORK_FRAME_PACER_HPP
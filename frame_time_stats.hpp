@@ -0,0 +1,128 @@
+#ifndef CGCOURSEWORK_FRAME_TIME_STATS_HPP
+#define CGCOURSEWORK_FRAME_TIME_STATS_HPP
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+#include "functions.hpp"
+
+/**
+ * @brief collects frame times and reports min/avg/percentiles
+ */
+class FrameTimeStats {
+  std::vector<double> frameTimes{};///< frame times in milliseconds, in order they were added
+  size_t maxFrames{0};             ///< if not 0 only this many most recent frames are kept
+
+ public:
+  struct Summary {
+	size_t frames{0};
+	double min{0};
+	double avg{0};
+	double p50{0};
+	double p95{0};
+	double p99{0};
+	double max{0};
+  };
+
+  FrameTimeStats() = default;
+  /**
+   * @param _maxFrames keep only this many most recent frame times
+   */
+  explicit FrameTimeStats(size_t _maxFrames) {
+	maxFrames = _maxFrames;
+	frameTimes.reserve(maxFrames);
+  }
+
+  void reserve(size_t frames) {
+	frameTimes.reserve(frames);
+  }
+
+  /**
+   * @brief records frame time
+   * @param milliseconds time it took to produce a frame
+   */
+  void add(double milliseconds) {
+	if (maxFrames != 0 && frameTimes.size() >= maxFrames) frameTimes.erase(frameTimes.begin());
+	frameTimes.push_back(milliseconds);
+  }
+
+  void clear() {
+	frameTimes.clear();
+  }
+
+  [[nodiscard]] const std::vector<double> &getFrameTimes() const {
+	return frameTimes;
+  }
+
+  /**
+   * @brief calculates min/avg/max and nearest-rank percentiles of recorded frame times
+   * @return Summary, all zeros if nothing was recorded
+   */
+  [[nodiscard]] Summary summarize() const {
+	Summary summary;
+	if (frameTimes.empty()) return summary;
+	std::vector<double> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	summary.frames = sorted.size();
+	summary.min = sorted.front();
+	summary.max = sorted.back();
+	summary.avg = std::accumulate(sorted.begin(), sorted.end(), 0.0) / (double)sorted.size();
+	summary.p50 = percentile(sorted, 50);
+	summary.p95 = percentile(sorted, 95);
+	summary.p99 = percentile(sorted, 99);
+	return summary;
+  }
+
+  /**
+   * @brief writes report to file, format is picked by extension
+   * @details .csv appends one summary row (header is written only for new file) so runs of different builds can be compared,
+   * anything else is written as JSON with summary and every frame time
+   * @param filepath where to write report
+   * @param label name of the run (e.g. build or scene name)
+   * @return true on success
+   */
+  bool writeReport(const std::string &filepath, const std::string &label = "default") const {
+	auto summary = summarize();
+	bool isCsv = std::filesystem::path(filepath).extension() == ".csv";
+	bool isNewFile = !std::filesystem::exists(filepath);
+	std::ofstream stream(filepath, isCsv ? std::ios::app : std::ios::trunc);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to write frame time report to: " << filepath;
+	  return false;
+	}
+	if (isCsv) {
+	  if (isNewFile) stream << "label,frames,min_ms,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+	  stream << label << "," << summary.frames << "," << summary.min << "," << summary.avg << "," << summary.p50 << ","
+			 << summary.p95 << "," << summary.p99 << "," << summary.max << "\n";
+	} else {
+	  stream << "{\n"
+			 << "  \"label\": \"" << label << "\",\n"
+			 << "  \"frames\": " << summary.frames << ",\n"
+			 << "  \"min_ms\": " << summary.min << ",\n"
+			 << "  \"avg_ms\": " << summary.avg << ",\n"
+			 << "  \"p50_ms\": " << summary.p50 << ",\n"
+			 << "  \"p95_ms\": " << summary.p95 << ",\n"
+			 << "  \"p99_ms\": " << summary.p99 << ",\n"
+			 << "  \"max_ms\": " << summary.max << ",\n"
+			 << "  \"frame_times_ms\": [";
+	  for (size_t i = 0; i < frameTimes.size(); ++i) {
+		stream << (i == 0 ? "" : ", ") << frameTimes[i];
+	  }
+	  stream << "]\n}\n";
+	}
+	LOG_S(INFO) << "Frame times (" << summary.frames << " frames): min " << summary.min << " ms, avg " << summary.avg
+				<< " ms, p50 " << summary.p50 << " ms, p95 " << summary.p95 << " ms, p99 " << summary.p99 << " ms";
+	LOG_S(INFO) << "Frame time report written to: " << filepath;
+	return true;
+  }
+
+ private:
+  static double percentile(const std::vector<double> &sorted, double p) {
+	auto rank = (size_t)std::ceil(p / 100.0 * (double)sorted.size());
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+  }
+};
+
+#endif//CGCOURSEWORK_FRAME_TIME_STATS_HPP
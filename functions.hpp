@@ -3,7 +3,7 @@
 //
 #ifndef CG_LABS_FUNCTIONS_HPP
 #define CG_LABS_FUNCTIONS_HPP
-#if defined(__APPLE__)
+#if defined(__APPLE__) || defined(__linux__)
 #define LOGURU_WITH_STREAMS 1
   #include "libs/loguru.cpp"
 #endif
@@ -18,10 +18,12 @@ INITIALIZE_EASYLOGGINGPP
 #include <GLFW/glfw3.h>
 
 
+#include <filesystem>
+#include <fstream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#if defined(__APPLE__)
+#if defined(__APPLE__) || defined(__linux__)
 #define ASSERT(X) \
 	if (!(X)) __builtin_trap()
 #endif
@@ -32,11 +34,18 @@ INITIALIZE_EASYLOGGINGPP
 #endif
 /**
  * @brief checks if GL function call failed or succeeded
+ * @details every check is a glGetError round trip to the driver, so in release builds (NDEBUG)
+ * the call is made unchecked and errors are reported by KHR_debug output (see GlDebug).
+ * Define VL_GL_STRICT to keep per-call checks in release builds.
  **/
+#if defined(NDEBUG) && !defined(VL_GL_STRICT)
+#define glCall(x) x
+#else
 #define glCall(x)  \
   glClearErrors(); \
   x;               \
   ASSERT(glLogCall(#x, __FILE__, __LINE__))
+#endif
 #if defined(__WIN32__)
 #define  uint unsigned int
 #endif
@@ -70,6 +79,69 @@ bool isLinux() {
 #endif
   return false;
 }
+/**
+ * @brief checks if flag was passed on command line
+ * @param flag flag to look for (e.g. "--headless")
+ * @return true if flag is present, false otherwise
+ **/
+bool isFlagPresent(int argc, char *argv[], const std::string &flag) {
+  for (int i = 1; i < argc; ++i) {
+	if (flag == argv[i]) return true;
+  }
+  return false;
+}
+/**
+ * @brief returns value that follows flag on command line
+ * @param flag flag to look for (e.g. "--frames")
+ * @param fallback returned if flag is absent or has no value
+ * @return value of the flag
+ **/
+std::string getFlagValue(int argc, char *argv[], const std::string &flag, const std::string &fallback = {}) {
+  for (int i = 1; i < argc - 1; ++i) {
+	if (flag == argv[i]) return argv[i + 1];
+  }
+  return fallback;
+}
+/**
+ * @brief reads whole file to memory
+ * @param filepath file to read
+ * @return content of the file, empty if it can't be read
+ **/
+std::vector<unsigned char> readBinaryFile(const std::string &filepath) {
+  std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+  if (stream.fail()) return {};
+  std::vector<unsigned char> content((size_t)stream.tellg());
+  stream.seekg(0);
+  stream.read((char *)content.data(), (std::streamsize)content.size());
+  return content;
+}
+/**
+ * @brief FNV-1a, 64 bit
+ * @param seed result of previous call to hash several buffers as one
+ **/
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 14695981039346656037ull) {
+  for (size_t i = 0; i < size; ++i) seed = (seed ^ ((const unsigned char *)data)[i]) * 1099511628211ull;
+  return seed;
+}
+/**
+ * @brief writes whole file under temporary name and renames it, so other instance never reads half written file
+ * @param filepath file to write, missing directories are created
+ * @param content content of the file
+ * @return true if file was written, false otherwise (temporary file is removed)
+ **/
+bool writeFileAtomically(const std::string &filepath, const std::vector<unsigned char> &content) {
+  std::error_code error;
+  std::filesystem::path path(filepath);
+  if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+  std::string temporaryPath = filepath + ".tmp";
+  std::ofstream stream(temporaryPath, std::ios::binary);
+  stream.write((const char *)content.data(), (std::streamsize)content.size());
+  stream.close();// flushes, so failed flush is caught too
+  if (stream) std::filesystem::rename(temporaryPath, filepath, error);
+  if (stream && !error) return true;
+  std::filesystem::remove(temporaryPath, error);
+  return false;
+}
 std::string glErrorToString(GLenum error) {
   switch (error) {
     case GL_INVALID_ENUM: return "INVALID ENUM";
@@ -134,11 +206,6 @@ std::vector<float> vec3ArrayToFloatArray(std::vector<glm::vec3> arrayOfVec3) {
   return floatArray;
 }
 
-void debugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
-                  const GLchar *message, const void *userParam) {
-  // Print, log, whatever based on the enums and message
-}
-
 void logInitWin([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
 #if defined(__WIN32__)
   el::Configurations defaultConf;
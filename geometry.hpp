@@ -0,0 +1,88 @@
+#ifndef CGCOURSEWORK_GEOMETRY_HPP
+#define CGCOURSEWORK_GEOMETRY_HPP
+
+#include <memory>
+#include <unordered_map>
+
+#include "Buffers/index_buffer.hpp"
+#include "Buffers/vertex_array.hpp"
+#include "buffer.hpp"
+#include "gpu_memory.hpp"
+#include "obj_loader.hpp"
+
+/**
+ * @brief vertex array with its buffers, index buffers and bounds, shared by every Mesh drawing the same model
+ * @details meshes hold it through std::shared_ptr and GPU objects are deleted with the last of them.
+ * Geometry of a loaded file can be found by name, so loading the same file again costs no uploads.
+ */
+class Geometry {
+ public:
+  struct Lod {
+	IndexBuffer *indexBuffer;
+	float error;///< in object units
+  };
+
+  std::vector<float> coordinates;///< kept on CPU for generated normals, colors and texture coordinates
+  std::vector<Buffer> buffers;
+  VertexArray vao;
+  IndexBuffer *indexBuffer{nullptr};
+  std::vector<Lod> lods;///< coarser levels of indexBuffer, drawn when their error is small on screen
+  glm::mat4 dequantization{1.f};///< turns quantized positions back to object space, identity for float positions
+  glm::vec3 boundsCenter{0};
+  float boundsRadius{0};
+  ObjLoader::MaterialInfo material;///< material geometry was imported with, meshes keep their own copy
+  bool compiled{false};///< buffers are uploaded and attached to vao, compiling again does nothing
+
+  Geometry() = default;
+  explicit Geometry(std::vector<float> _coordinates) : coordinates(std::move(_coordinates)) {}
+  Geometry(const Geometry &) = delete;
+  Geometry &operator=(const Geometry &) = delete;
+
+  ~Geometry() {
+	for (auto &buffer : buffers) {
+	  GpuMemory::release(GpuMemory::BUFFER, buffer.rendererID);
+	  glCall(glDeleteBuffers(1, &buffer.rendererID));
+	}
+	deleteIndexBuffer(indexBuffer);
+	for (auto &lod : lods) deleteIndexBuffer(lod.indexBuffer);
+  }
+
+  /**
+   * @brief sets name GPU memory of this geometry is reported under
+   */
+  void setOwner(const std::string &name) const {
+	for (auto &buffer : buffers) GpuMemory::setOwner(GpuMemory::BUFFER, buffer.rendererID, name);
+	if (indexBuffer != nullptr) GpuMemory::setOwner(GpuMemory::INDEX_BUFFER, indexBuffer->rendererID, name);
+	for (auto &lod : lods) GpuMemory::setOwner(GpuMemory::INDEX_BUFFER, lod.indexBuffer->rendererID, name);
+  }
+
+  /**
+   * @return geometry shared under name while any mesh still uses it, nullptr otherwise
+   */
+  static std::shared_ptr<Geometry> find(const std::string &name) {
+	auto found = registry().find(name);
+	return found == registry().end() ? nullptr : found->second.lock();
+  }
+
+  /**
+   * @brief makes geometry findable by name, registry does not keep it alive
+   */
+  static void share(const std::string &name, const std::shared_ptr<Geometry> &geometry) {
+	registry()[name] = geometry;
+  }
+
+ private:
+  static std::unordered_map<std::string, std::weak_ptr<Geometry>> &registry() {
+	static std::unordered_map<std::string, std::weak_ptr<Geometry>> shared;
+	return shared;
+  }
+
+  static void deleteIndexBuffer(IndexBuffer *buffer) {
+	if (buffer == nullptr) return;
+	GpuMemory::release(GpuMemory::INDEX_BUFFER, buffer->rendererID);
+	glCall(glDeleteBuffers(1, &buffer->rendererID));
+	delete buffer;
+  }
+};
+
+#endif//CGCOURSEWORK_GEOMETRY_HPP
@@ -0,0 +1,202 @@
+#ifndef CGCOURSEWORK_GL_DEBUG_HPP
+#define CGCOURSEWORK_GL_DEBUG_HPP
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "functions.hpp"
+
+/**
+ * @brief receives driver messages through KHR_debug callback and logs them from a separate thread
+ * @details messages below minimal severity are disabled in the driver with glDebugMessageControl, so they cost nothing.
+ * Callback only copies the message to a queue, logging is done by logger thread. In debug builds output is
+ * synchronous so the message arrives while the offending call is still on the stack.
+ */
+class GlDebug {
+ public:
+  struct Settings {
+	GLenum minSeverity{GL_DEBUG_SEVERITY_LOW};///< GL_DEBUG_SEVERITY_HIGH, _MEDIUM, _LOW or _NOTIFICATION
+	std::vector<GLenum> ignoredSources{};     ///< GL_DEBUG_SOURCE_* that are disabled completely
+	int maxRepeats{10};                       ///< same message id is logged at most this many times
+#if defined(NDEBUG)
+	bool synchronous{false};
+#else
+	bool synchronous{true};
+#endif
+  };
+
+ private:
+  struct Message {
+	GLenum source;
+	GLenum type;
+	GLuint id;
+	GLenum severity;
+	std::string text;
+	int occurrence;///< how many times message with this id was received, including this one
+  };
+  struct State {
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<Message> queue;
+	std::unordered_map<GLuint, int> repeats;
+	std::thread logger;
+	bool running{false};
+	int maxRepeats{10};
+  };
+  static State &state() {
+	static State s;
+	return s;
+  }
+
+ public:
+  /**
+   * @brief enables debug output of current context and starts logger thread
+   * @return false if context doesn't support KHR_debug (e.g. macOS)
+   */
+  static bool install(const Settings &settings) {
+	if (!GLAD_GL_KHR_debug) {
+	  LOG_S(INFO) << "KHR_debug is not supported, GL errors are checked only by glCall()";
+	  return false;
+	}
+	auto &s = state();
+	s.maxRepeats = settings.maxRepeats;
+	if (!s.running) {
+	  s.running = true;
+	  s.logger = std::thread(loggerLoop);
+	}
+	glEnable(GL_DEBUG_OUTPUT);
+	if (settings.synchronous) glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	else glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(debugMessage, nullptr);
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+	for (GLenum severity : {GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM}) {
+	  if (severityRank(severity) >= severityRank(settings.minSeverity)) break;
+	  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_FALSE);
+	}
+	for (GLenum source : settings.ignoredSources) {
+	  glDebugMessageControl(source, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	}
+	GLint flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	LOG_S(INFO) << "GL debug output enabled, min severity: " << severityToString(settings.minSeverity)
+				<< (settings.synchronous ? ", synchronous" : ", asynchronous")
+				<< ((flags & GL_CONTEXT_FLAG_DEBUG_BIT) ? ", debug context" : "");
+	return true;
+  }
+
+  /**
+   * @brief logs queued messages and stops logger thread, call it before context is destroyed
+   */
+  static void shutdown() {
+	auto &s = state();
+	{
+	  std::lock_guard<std::mutex> lock(s.mutex);
+	  if (!s.running) return;
+	  s.running = false;
+	}
+	s.condition.notify_one();
+	s.logger.join();
+  }
+
+  /**
+   * @brief parses severity name used on command line: high, medium, low or notification
+   */
+  static GLenum severityFromString(const std::string &name) {
+	if (name == "high") return GL_DEBUG_SEVERITY_HIGH;
+	if (name == "medium") return GL_DEBUG_SEVERITY_MEDIUM;
+	if (name == "notification") return GL_DEBUG_SEVERITY_NOTIFICATION;
+	return GL_DEBUG_SEVERITY_LOW;
+  }
+
+  static std::string severityToString(GLenum severity) {
+	switch (severity) {
+	  case GL_DEBUG_SEVERITY_HIGH: return "high";
+	  case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+	  case GL_DEBUG_SEVERITY_LOW: return "low";
+	  default: return "notification";
+	}
+  }
+
+  static std::string sourceToString(GLenum source) {
+	switch (source) {
+	  case GL_DEBUG_SOURCE_API: return "API";
+	  case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+	  case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+	  case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+	  case GL_DEBUG_SOURCE_APPLICATION: return "application";
+	  default: return "other";
+	}
+  }
+
+  static std::string typeToString(GLenum type) {
+	switch (type) {
+	  case GL_DEBUG_TYPE_ERROR: return "error";
+	  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+	  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+	  case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+	  case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+	  case GL_DEBUG_TYPE_MARKER: return "marker";
+	  default: return "other";
+	}
+  }
+
+  /**
+   * @brief KHR_debug callback, only queues the message
+   */
+  static void APIENTRY debugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+									const GLchar *message, [[maybe_unused]] const void *userParam) {
+	auto &s = state();
+	{
+	  std::lock_guard<std::mutex> lock(s.mutex);
+	  int occurrence = ++s.repeats[id];
+	  if (occurrence > s.maxRepeats) return;
+	  s.queue.push_back({source, type, id, severity, std::string(message, length > 0 ? (size_t)length : strlen(message)), occurrence});
+	}
+	s.condition.notify_one();
+  }
+
+ private:
+  static int severityRank(GLenum severity) {
+	switch (severity) {
+	  case GL_DEBUG_SEVERITY_HIGH: return 3;
+	  case GL_DEBUG_SEVERITY_MEDIUM: return 2;
+	  case GL_DEBUG_SEVERITY_LOW: return 1;
+	  default: return 0;
+	}
+  }
+
+  static void loggerLoop() {
+	auto &s = state();
+	std::unique_lock<std::mutex> lock(s.mutex);
+	while (true) {
+	  s.condition.wait(lock, [&s] { return !s.queue.empty() || !s.running; });
+	  while (!s.queue.empty()) {
+		Message message = std::move(s.queue.front());
+		s.queue.pop_front();
+		lock.unlock();
+		log(message, message.occurrence == s.maxRepeats);
+		lock.lock();
+	  }
+	  if (!s.running) return;
+	}
+  }
+
+  static void log(const Message &message, bool isLast) {
+	std::string text = "GL " + sourceToString(message.source) + " " + typeToString(message.type) + " (" +
+		severityToString(message.severity) + ", id " + std::to_string(message.id) + "): " + message.text +
+		(isLast ? " [further messages with this id are suppressed]" : "");
+	if (message.type == GL_DEBUG_TYPE_ERROR || message.severity == GL_DEBUG_SEVERITY_HIGH) {
+	  LOG_S(ERROR) << text;
+	} else if (message.severity == GL_DEBUG_SEVERITY_MEDIUM) {
+	  LOG_S(WARNING) << text;
+	} else {
+	  LOG_S(INFO) << text;
+	}
+  }
+};
+
+#endif//CGCOURSEWORK_GL_DEBUG_HPP
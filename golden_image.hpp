@@ -0,0 +1,197 @@
+#ifndef CGCOURSEWORK_GOLDEN_IMAGE_HPP
+#define CGCOURSEWORK_GOLDEN_IMAGE_HPP
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+#include "camera_path.hpp"
+#include "libs/lodepng.hpp"
+#include "window.hpp"
+
+/**
+ * @brief renders scene from every keyframe of a CameraPath, compares result with reference PNGs and measures frame time
+ * @details references are stored as <directory>/pose_<n>.png and are written only in update mode, a missing
+ * reference fails its pose so a fresh checkout or a typo in the directory can't pass silently.
+ * When pose doesn't match, <directory>/pose_<n>_actual.png and pose_<n>_diff.png are written next to reference.
+ */
+class GoldenImageTest {
+ public:
+  struct Image {
+	std::vector<unsigned char> pixels;///< RGBA8, top row first
+	unsigned int width{0};
+	unsigned int height{0};
+  };
+  struct Result {
+	size_t pose{0};
+	double milliseconds{0};  ///< median frame time of this pose
+	long mismatchedPixels{0};///< pixels where any channel differs more than tolerance
+	int maxDifference{0};    ///< biggest per channel difference in the image
+	bool passed{false};
+	bool updated{false};///< reference was (re)written instead of compared
+	bool missing{false};///< there was no reference to compare with, pose fails
+  };
+
+ private:
+  std::string directory;
+  int tolerance{2};
+  long maxMismatchedPixels{0};
+  int repeats{10};
+  bool update{false};
+  std::vector<Result> results{};
+
+ public:
+  /**
+   * @param _directory where reference images and report are stored
+   * @param _tolerance max allowed difference of a single channel of a pixel
+   * @param _maxMismatchedPixels how many pixels may exceed tolerance before pose fails
+   * @param _repeats how many times each pose is rendered for timing
+   * @param _update overwrite references with current renders
+   */
+  GoldenImageTest(std::string _directory, int _tolerance, long _maxMismatchedPixels, int _repeats, bool _update) {
+	directory = std::move(_directory);
+	tolerance = _tolerance;
+	maxMismatchedPixels = _maxMismatchedPixels;
+	repeats = std::max(1, _repeats);
+	update = _update;
+  }
+
+  /**
+   * @brief renders every pose and compares it with reference
+   * @param window window to read rendered pixels from
+   * @param camera camera that is moved between poses
+   * @param poses every keyframe is one pose
+   * @param drawFrame renders the whole scene, without swapping buffers
+   * @return true if every pose passed
+   */
+  bool run(Window *window, Camera *camera, const CameraPath &poses, const std::function<void()> &drawFrame) {
+	std::filesystem::create_directories(directory);
+	results.clear();
+	for (size_t pose = 0; pose < poses.size(); ++pose) {
+	  poses.apply(camera, poses.size() > 1 ? (double)pose / (double)(poses.size() - 1) : 0.0);
+	  std::vector<double> frameTimes;
+	  for (int i = 0; i < repeats; ++i) {
+		double start = glfwGetTime();
+		drawFrame();
+		glFinish();
+		frameTimes.push_back((glfwGetTime() - start) * 1000.0);
+	  }
+	  std::sort(frameTimes.begin(), frameTimes.end());
+	  auto size = window->getWindowSize();
+	  Image actual = fromFramebuffer(window->readPixels(), (unsigned int)size.x, (unsigned int)size.y);
+
+	  Result result;
+	  result.pose = pose;
+	  result.milliseconds = frameTimes[frameTimes.size() / 2];
+	  std::string referencePath = posePath(pose, "");
+	  Image reference;
+	  if (update) {
+		result.updated = save(referencePath, actual);
+		result.passed = result.updated;
+	  } else if (!std::filesystem::exists(referencePath)) {
+		result.missing = true;
+		save(posePath(pose, "_actual"), actual);
+	  } else if (load(referencePath, reference)) {
+		Image diff = compare(actual, reference, result);
+		result.passed = result.mismatchedPixels <= maxMismatchedPixels;
+		if (!result.passed) {
+		  save(posePath(pose, "_actual"), actual);
+		  save(posePath(pose, "_diff"), diff);
+		}
+	  }
+	  LOG_S(INFO) << "Golden pose " << pose << ": " << (result.updated ? "reference written" : (result.missing ? "MISSING reference, run with --golden-update" : (result.passed ? "OK" : "FAIL")))
+				  << ", " << result.mismatchedPixels << " mismatched pixels (max diff " << result.maxDifference << "), "
+				  << result.milliseconds << " ms";
+	  results.push_back(result);
+	}
+	writeReport(directory + "/report.csv");
+	return std::all_of(results.begin(), results.end(), [](const Result &result) { return result.passed; });
+  }
+
+  [[nodiscard]] const std::vector<Result> &getResults() const {
+	return results;
+  }
+
+  /**
+   * @brief compares two images pixel by pixel
+   * @param result mismatchedPixels and maxDifference are filled in
+   * @return image where mismatched pixels are red and the rest is dimmed reference
+   */
+  Image compare(const Image &actual, const Image &reference, Result &result) const {
+	Image diff{reference.pixels, reference.width, reference.height};
+	if (actual.width != reference.width || actual.height != reference.height) {
+	  LOG_S(ERROR) << "Golden image size mismatch: " << actual.width << "x" << actual.height << " vs "
+				   << reference.width << "x" << reference.height;
+	  result.mismatchedPixels = (long)reference.width * reference.height;
+	  result.maxDifference = 255;
+	  return diff;
+	}
+	for (size_t i = 0; i < actual.pixels.size(); i += 4) {
+	  int pixelDifference = 0;
+	  for (size_t channel = 0; channel < 3; ++channel) {// alpha is ignored
+		pixelDifference = std::max(pixelDifference, std::abs((int)actual.pixels[i + channel] - (int)reference.pixels[i + channel]));
+	  }
+	  result.maxDifference = std::max(result.maxDifference, pixelDifference);
+	  bool mismatched = pixelDifference > tolerance;
+	  if (mismatched) result.mismatchedPixels++;
+	  for (size_t channel = 0; channel < 3; ++channel) {
+		diff.pixels[i + channel] = mismatched ? (channel == 0 ? 255 : 0) : (unsigned char)(reference.pixels[i + channel] / 4);
+	  }
+	  diff.pixels[i + 3] = 255;
+	}
+	return diff;
+  }
+
+  static bool load(const std::string &filepath, Image &image) {
+	unsigned int error = lodepng::decode(image.pixels, image.width, image.height, filepath);
+	if (error) {
+	  LOG_S(ERROR) << "Unable to load golden image " << filepath << ": " << lodepng_error_text(error);
+	  return false;
+	}
+	return true;
+  }
+
+  static bool save(const std::string &filepath, const Image &image) {
+	unsigned int error = lodepng::encode(filepath, image.pixels, image.width, image.height);
+	if (error) {
+	  LOG_S(ERROR) << "Unable to save golden image " << filepath << ": " << lodepng_error_text(error);
+	  return false;
+	}
+	return true;
+  }
+
+  /**
+   * @brief flips pixels read with glReadPixels so the first row is the top one and makes image opaque
+   */
+  static Image fromFramebuffer(const std::vector<unsigned char> &pixels, unsigned int width, unsigned int height) {
+	Image image{std::vector<unsigned char>(pixels.size()), width, height};
+	size_t rowSize = (size_t)width * 4;
+	for (size_t row = 0; row < height; ++row) {
+	  std::copy_n(pixels.begin() + (long)(row * rowSize), rowSize, image.pixels.begin() + (long)((height - 1 - row) * rowSize));
+	}
+	for (size_t i = 3; i < image.pixels.size(); i += 4) image.pixels[i] = 255;
+	return image;
+  }
+
+ private:
+  [[nodiscard]] std::string posePath(size_t pose, const std::string &suffix) const {
+	return directory + "/pose_" + std::to_string(pose) + suffix + ".png";
+  }
+
+  void writeReport(const std::string &filepath) const {
+	std::ofstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to write golden image report to: " << filepath;
+	  return;
+	}
+	stream << "pose,frame_ms,mismatched_pixels,max_difference,passed,updated,missing\n";
+	for (auto &result : results) {
+	  stream << result.pose << "," << result.milliseconds << "," << result.mismatchedPixels << "," << result.maxDifference << ","
+			 << result.passed << "," << result.updated << "," << result.missing << "\n";
+	}
+	LOG_S(INFO) << "Golden image report written to: " << filepath;
+  }
+};
+
+#endif//CGCOURSEWORK_GOLDEN_IMAGE_HPP
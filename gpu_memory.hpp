@@ -0,0 +1,180 @@
+#ifndef CGCOURSEWORK_GPU_MEMORY_HPP
+#define CGCOURSEWORK_GPU_MEMORY_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "functions.hpp"
+
+/**
+ * @brief bookkeeping of GPU allocations made by the app: who owns what and how big it is
+ * @details allocations are keyed by kind and GL name, sizes are what was requested from GL
+ * (driver padding and alignment are not visible from here). Every GL name is expected to be
+ * tracked once, tracking the same name again replaces previous record.
+ */
+class GpuMemory {
+ public:
+  enum Kind {
+	BUFFER,
+	INDEX_BUFFER,
+	TEXTURE,
+	CUBE_MAP,
+	RENDERBUFFER
+  };
+  struct Allocation {
+	Kind kind{BUFFER};
+	std::string owner;
+	size_t bytes{0};
+  };
+  struct OwnerUsage {
+	std::string owner;
+	size_t bytes{0};
+	size_t allocations{0};
+	size_t textures{0};///< textures and cube maps, more than one per texture owner means it was loaded twice
+  };
+
+ private:
+  static std::map<std::pair<Kind, unsigned int>, Allocation> &allocations() {
+	static std::map<std::pair<Kind, unsigned int>, Allocation> map;
+	return map;
+  }
+  static size_t &liveBytes() {
+	static size_t bytes{0};
+	return bytes;
+  }
+  static size_t &peakBytes() {
+	static size_t bytes{0};
+	return bytes;
+  }
+
+ public:
+  static constexpr const char *unowned = "<unowned>";
+
+  /**
+   * @brief records new allocation
+   * @param id GL name of the object
+   * @param bytes size of the storage
+   * @param owner asset the allocation belongs to (model or texture path), can be changed later with setOwner()
+   */
+  static void track(Kind kind, unsigned int id, size_t bytes, const std::string &owner = unowned) {
+	auto &allocation = allocations()[{kind, id}];
+	liveBytes() = liveBytes() - allocation.bytes + bytes;
+	allocation = {kind, owner, bytes};
+	peakBytes() = std::max(peakBytes(), liveBytes());
+  }
+
+  /**
+   * @brief forgets allocation, call it when GL object is deleted
+   */
+  static void release(Kind kind, unsigned int id) {
+	auto it = allocations().find({kind, id});
+	if (it == allocations().end()) return;
+	liveBytes() -= it->second.bytes;
+	allocations().erase(it);
+  }
+
+  static void setOwner(Kind kind, unsigned int id, const std::string &owner) {
+	auto it = allocations().find({kind, id});
+	if (it != allocations().end()) it->second.owner = owner;
+  }
+
+  [[nodiscard]] static size_t getLiveBytes() {
+	return liveBytes();
+  }
+  [[nodiscard]] static size_t getPeakBytes() {
+	return peakBytes();
+  }
+
+  /**
+   * @brief size of 2D image with its whole mip chain
+   * @param bytesPerPixel bytes of one texel of base level
+   * @param mipmaps whether mip levels down to 1x1 are allocated
+   */
+  static size_t textureBytes(int width, int height, int bytesPerPixel, bool mipmaps) {
+	size_t bytes = (size_t)width * height * bytesPerPixel;
+	while (mipmaps && (width > 1 || height > 1)) {
+	  width = std::max(1, width / 2);
+	  height = std::max(1, height / 2);
+	  bytes += (size_t)width * height * bytesPerPixel;
+	}
+	return bytes;
+  }
+
+  /**
+   * @brief live allocations summed per owner, biggest first
+   */
+  static std::vector<OwnerUsage> perOwner() {
+	std::map<std::string, OwnerUsage> owners;
+	for (auto &[key, allocation] : allocations()) {
+	  auto &usage = owners[allocation.owner];
+	  usage.owner = allocation.owner;
+	  usage.bytes += allocation.bytes;
+	  usage.allocations++;
+	  if (allocation.kind == TEXTURE || allocation.kind == CUBE_MAP) usage.textures++;
+	}
+	std::vector<OwnerUsage> result;
+	result.reserve(owners.size());
+	for (auto &[owner, usage] : owners) result.push_back(usage);
+	std::sort(result.begin(), result.end(), [](const OwnerUsage &a, const OwnerUsage &b) { return a.bytes > b.bytes; });
+	return result;
+  }
+
+  /**
+   * @brief free video memory reported by the driver, if it exposes NVX_gpu_memory_info or ATI_meminfo
+   * @return kilobytes, -1 if unknown
+   */
+  static long driverAvailableKb() {
+	GLint kb[4]{-1, -1, -1, -1};
+	if (GLAD_GL_NVX_gpu_memory_info) {
+	  glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, kb);
+	} else if (GLAD_GL_ATI_meminfo) {
+	  glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kb);
+	}
+	return kb[0];
+  }
+
+  /**
+   * @brief one line summary of live and peak bytes
+   */
+  static std::string summary() {
+	std::ostringstream ss;
+	ss.precision(3);
+	ss << "gpu mem " << (double)liveBytes() / (1024.0 * 1024.0) << " MB (peak " << (double)peakBytes() / (1024.0 * 1024.0) << " MB)";
+	return ss.str();
+  }
+
+  /**
+   * @brief writes per owner CSV report and logs the biggest owners and duplicated textures
+   * @param filepath where to write report
+   * @return true on success
+   */
+  static bool writeReport(const std::string &filepath) {
+	auto owners = perOwner();
+	std::ofstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to write GPU memory report to: " << filepath;
+	  return false;
+	}
+	stream << "owner,bytes,allocations,textures\n";
+	for (auto &usage : owners) {
+	  stream << "\"" << usage.owner << "\"," << usage.bytes << "," << usage.allocations << "," << usage.textures << "\n";
+	}
+	LOG_S(INFO) << summary() << ", " << allocations().size() << " allocations, " << owners.size() << " owners";
+	for (size_t i = 0; i < std::min<size_t>(owners.size(), 10); ++i) {
+	  LOG_S(INFO) << "  " << owners[i].owner << ": " << owners[i].bytes / 1024 << " KB in " << owners[i].allocations << " allocations";
+	}
+	for (auto &usage : owners) {
+	  if (usage.textures > 1 && usage.textures == usage.allocations) {
+		LOG_S(WARNING) << "Texture " << usage.owner << " is uploaded " << usage.textures << " times, " << usage.bytes / 1024 << " KB";
+	  }
+	}
+	long availableKb = driverAvailableKb();
+	if (availableKb >= 0) LOG_S(INFO) << "Driver reports " << availableKb / 1024 << " MB of video memory available";
+	LOG_S(INFO) << "GPU memory report written to: " << filepath;
+	return true;
+  }
+};
+
+#endif//CGCOURSEWORK_GPU_MEMORY_HPP
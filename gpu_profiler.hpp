@@ -0,0 +1,228 @@
+#ifndef CGCOURSEWORK_GPU_PROFILER_HPP
+#define CGCOURSEWORK_GPU_PROFILER_HPP
+
+#include <array>
+#include <deque>
+#include <fstream>
+#include <map>
+
+#include "functions.hpp"
+
+/**
+ * @brief measures GPU time of render passes with GL_TIMESTAMP queries
+ * @details queries of a frame are read back framesInFlight frames later, so reading never waits for the GPU.
+ * If results are still not ready by then the frame is dropped instead of stalling.
+ */
+class GpuProfiler {
+ public:
+  struct PassTiming {
+	std::string name;
+	double milliseconds{0};
+	int depth{0};///< nesting level, 0 for top level passes
+  };
+  struct FrameTimings {
+	long frame{-1};
+	std::vector<PassTiming> passes;
+  };
+
+ private:
+  static constexpr int framesInFlight = 4;
+  static constexpr size_t maxHistory = 10000;
+  struct PendingPass {
+	std::string name;
+	GLuint begin{0};
+	GLuint end{0};
+	int depth{0};
+  };
+  struct FrameSlot {
+	long frame{-1};
+	std::vector<PendingPass> passes;
+  };
+
+  bool enabled{false};
+  long frame{-1};
+  std::array<FrameSlot, framesInFlight> slots{};
+  std::vector<size_t> openPasses{};///< indices of passes in current slot that were not ended yet
+  std::vector<GLuint> freeQueries{};
+  std::deque<FrameTimings> history{};
+  long droppedFrames{0};
+
+ public:
+  /**
+   * @brief RAII helper that wraps a scope in beginPass()/endPass()
+   */
+  class Scope {
+	GpuProfiler *profiler;
+
+   public:
+	Scope(GpuProfiler *_profiler, const std::string &name) : profiler(_profiler) {
+	  profiler->beginPass(name);
+	}
+	~Scope() {
+	  profiler->endPass();
+	}
+	Scope(const Scope &) = delete;
+	Scope &operator=(const Scope &) = delete;
+  };
+
+  explicit GpuProfiler(bool _enabled = true) {
+	enabled = _enabled;
+  }
+  ~GpuProfiler() {
+	for (auto &slot : slots) {
+	  for (auto &pass : slot.passes) {
+		releaseQuery(pass.begin);
+		releaseQuery(pass.end);
+	  }
+	}
+	if (!freeQueries.empty()) {
+	  glCall(glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data()));
+	}
+  }
+
+  [[nodiscard]] bool isEnabled() const {
+	return enabled;
+  }
+
+  /**
+   * @brief starts new frame, collects results of the frame that was recorded framesInFlight frames ago
+   */
+  void beginFrame() {
+	if (!enabled) return;
+	frame++;
+	auto &slot = slots[frame % framesInFlight];
+	collect(slot, false);
+	slot.frame = frame;
+	openPasses.clear();
+  }
+
+  /**
+   * @brief marks start of a pass, passes can be nested
+   * @param name name of the pass
+   */
+  void beginPass(const std::string &name) {
+	if (!enabled || frame < 0) return;
+	auto &slot = slots[frame % framesInFlight];
+	PendingPass pass{name, acquireQuery(), 0, (int)openPasses.size()};
+	glCall(glQueryCounter(pass.begin, GL_TIMESTAMP));
+	openPasses.push_back(slot.passes.size());
+	slot.passes.push_back(pass);
+  }
+
+  /**
+   * @brief marks end of the most recently started pass
+   */
+  void endPass() {
+	if (!enabled || openPasses.empty()) return;
+	auto &pass = slots[frame % framesInFlight].passes[openPasses.back()];
+	openPasses.pop_back();
+	pass.end = acquireQuery();
+	glCall(glQueryCounter(pass.end, GL_TIMESTAMP));
+  }
+
+  /**
+   * @brief waits for all frames that are still in flight, use before exporting at shutdown
+   */
+  void flush() {
+	if (!enabled) return;
+	for (long i = frame - framesInFlight + 1; i <= frame; ++i) {
+	  if (i < 0) continue;
+	  collect(slots[i % framesInFlight], true);
+	}
+  }
+
+  /**
+   * @brief returns timings of the most recent frame which results are available
+   * @return FrameTimings* or nullptr if no results are available yet
+   */
+  [[nodiscard]] const FrameTimings *getLatestFrame() const {
+	return history.empty() ? nullptr : &history.back();
+  }
+
+  [[nodiscard]] const std::deque<FrameTimings> &getHistory() const {
+	return history;
+  }
+
+  /**
+   * @brief writes every collected pass timing as CSV (frame,pass,depth,ms) and logs per pass averages
+   * @param filepath where to write timings
+   * @return true on success
+   */
+  bool exportCsv(const std::string &filepath) const {
+	std::ofstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to write GPU profile to: " << filepath;
+	  return false;
+	}
+	std::map<std::string, std::pair<double, long>> totals;
+	stream << "frame,pass,depth,ms\n";
+	for (auto &frameTimings : history) {
+	  for (auto &pass : frameTimings.passes) {
+		stream << frameTimings.frame << "," << pass.name << "," << pass.depth << "," << pass.milliseconds << "\n";
+		totals[pass.name].first += pass.milliseconds;
+		totals[pass.name].second++;
+	  }
+	}
+	for (auto &[name, total] : totals) {
+	  LOG_S(INFO) << "GPU pass " << name << ": avg " << total.first / (double)total.second << " ms";
+	}
+	if (droppedFrames > 0) {
+	  LOG_S(WARNING) << "GPU profiler dropped " << droppedFrames << " frames which results were not ready in time";
+	}
+	LOG_S(INFO) << "GPU profile written to: " << filepath;
+	return true;
+  }
+
+ private:
+  GLuint acquireQuery() {
+	if (freeQueries.empty()) {
+	  GLuint query;
+	  glCall(glGenQueries(1, &query));
+	  return query;
+	}
+	GLuint query = freeQueries.back();
+	freeQueries.pop_back();
+	return query;
+  }
+
+  void releaseQuery(GLuint query) {
+	if (query != 0) freeQueries.push_back(query);
+  }
+
+  void collect(FrameSlot &slot, bool wait) {
+	if (slot.frame < 0) return;
+	bool available = true;
+	if (!wait) {
+	  // GPU finishes queries in order, so if the last one is ready every one is
+	  for (auto it = slot.passes.rbegin(); it != slot.passes.rend(); ++it) {
+		if (it->end == 0) continue;
+		GLint ready = 0;
+		glCall(glGetQueryObjectiv(it->end, GL_QUERY_RESULT_AVAILABLE, &ready));
+		available = ready != 0;
+		break;
+	  }
+	}
+	if (available) {
+	  FrameTimings timings{slot.frame, {}};
+	  for (auto &pass : slot.passes) {
+		if (pass.end == 0) continue;// pass was never ended
+		GLuint64 begin, end;
+		glCall(glGetQueryObjectui64v(pass.begin, GL_QUERY_RESULT, &begin));
+		glCall(glGetQueryObjectui64v(pass.end, GL_QUERY_RESULT, &end));
+		timings.passes.push_back({pass.name, (double)(end - begin) / 1e6, pass.depth});
+	  }
+	  history.push_back(std::move(timings));
+	  if (history.size() > maxHistory) history.pop_front();
+	} else {
+	  droppedFrames++;
+	}
+	for (auto &pass : slot.passes) {
+	  releaseQuery(pass.begin);
+	  releaseQuery(pass.end);
+	}
+	slot.passes.clear();
+	slot.frame = -1;
+  }
+};
+
+#endif//CGCOURSEWORK_GPU_PROFILER_HPP
@@ -0,0 +1,150 @@
+#ifndef CGCOURSEWORK_KTX_FILE_HPP
+#define CGCOURSEWORK_KTX_FILE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// S3TC is not core and not in our glad, the enums come from EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+/**
+ * @brief block compressed 2D texture with all mip levels in KTX 1.1 container
+ * @details written by vlTextureCooker next to the source image (textures/metal.bmp -> textures/metal.ktx).
+ * Images are stored bottom row first (KTXorientation S=r,T=u), so they are uploaded without flipping.
+ */
+class KtxFile {
+ public:
+  struct Level {
+	int width, height;
+	size_t offset;///< in data
+	size_t size;
+  };
+
+  GLenum internalFormat{0};///< GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+  int width{0}, height{0};
+  std::vector<Level> levels;
+  std::vector<unsigned char> data;///< every level, one after another
+
+  /**
+   * @brief path of cooked file for source image
+   */
+  static std::string cookedPath(const std::string &source) {
+	return std::filesystem::path(source).replace_extension(".ktx").string();
+  }
+
+  /**
+   * @brief checks that cooked file exists and is not older than source image
+   */
+  static bool isUpToDate(const std::string &source) {
+	std::error_code error;
+	auto cookedTime = std::filesystem::last_write_time(cookedPath(source), error);
+	if (error) return false;
+	auto sourceTime = std::filesystem::last_write_time(source, error);
+	return error || cookedTime >= sourceTime;// cooked file alone is fine, source doesn't have to be shipped
+  }
+
+  /**
+   * @brief bytes of compressed level, blocks are 4x4 pixels
+   */
+  static size_t levelSize(GLenum format, int width, int height) {
+	size_t blocks = (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4);
+	return blocks * (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16);
+  }
+
+  /**
+   * @brief parses KTX file in memory
+   * @return empty string on success, otherwise what is wrong with the file
+   */
+  std::string parse(const std::vector<unsigned char> &file) {
+	if (file.size() < sizeof(identifier) + 13 * 4 || std::memcmp(file.data(), identifier, sizeof(identifier)) != 0) return "not a KTX 1.1 file";
+	uint32_t header[13];
+	std::memcpy(header, file.data() + sizeof(identifier), sizeof(header));
+	if (header[0] != 0x04030201) return "unsupported endianness";
+	if (header[1] != 0 || header[3] != 0) return "not compressed";
+	if (header[8] > 1 || header[9] > 0 || header[10] != 1) return "only 2D textures are supported";
+	internalFormat = header[4];
+	if (internalFormat != GL_COMPRESSED_RGB_S3TC_DXT1_EXT && internalFormat != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) return "unsupported format";
+	width = (int)header[6];
+	height = (int)header[7];
+	size_t position = sizeof(identifier) + sizeof(header) + header[12];
+	levels.clear();
+	data.clear();
+	int levelWidth = width, levelHeight = height;
+	for (uint32_t i = 0; i < std::max(1u, header[11]); ++i) {
+	  uint32_t size;
+	  if (position + 4 > file.size()) return "truncated";
+	  std::memcpy(&size, file.data() + position, 4);
+	  position += 4;
+	  if (position + size > file.size() || size != levelSize(internalFormat, levelWidth, levelHeight)) return "truncated";
+	  levels.push_back({levelWidth, levelHeight, data.size(), size});
+	  data.insert(data.end(), file.begin() + (long)position, file.begin() + (long)(position + size));
+	  position += (size + 3) & ~3u;
+	  levelWidth = std::max(1, levelWidth / 2);
+	  levelHeight = std::max(1, levelHeight / 2);
+	}
+	return "";
+  }
+
+  /**
+   * @return false if file can't be written
+   */
+  [[nodiscard]] bool write(const std::string &filepath) const {
+	std::ofstream stream(filepath, std::ios::binary);
+	if (stream.fail()) return false;
+	const char orientation[] = "KTXorientation\0S=r,T=u";
+	uint32_t keyValueSize = sizeof(orientation);
+	uint32_t keyValuePadded = (4 + keyValueSize + 3) & ~3u;
+	uint32_t header[13]{0x04030201, 0, 1, 0, internalFormat,
+						(uint32_t)(internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? GL_RGB : GL_RGBA),
+						(uint32_t)width, (uint32_t)height, 0, 0, 1, (uint32_t)levels.size(), keyValuePadded};
+	stream.write((const char *)identifier, sizeof(identifier));
+	stream.write((const char *)header, sizeof(header));
+	stream.write((const char *)&keyValueSize, 4);
+	stream.write(orientation, sizeof(orientation));
+	stream.write("\0\0\0", keyValuePadded - 4 - keyValueSize);
+	for (auto &level : levels) {
+	  auto size = (uint32_t)level.size;
+	  stream.write((const char *)&size, 4);
+	  stream.write((const char *)data.data() + level.offset, (long)level.size);
+	  stream.write("\0\0\0", ((size + 3) & ~3u) - size);
+	}
+	return !stream.fail();
+  }
+
+  /**
+   * @brief asks current context which compressed formats it supports, call it on GL thread before isSupported()
+   */
+  static void querySupportedFormats() {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+	supportedFormats().resize(count);
+	if (count > 0) glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, supportedFormats().data());
+  }
+
+  static bool isSupported(GLenum format) {
+	auto &formats = supportedFormats();
+	return std::find(formats.begin(), formats.end(), (GLint)format) != formats.end();
+  }
+
+ private:
+  static constexpr unsigned char identifier[12]{0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+  static std::vector<GLint> &supportedFormats() {
+	static std::vector<GLint> formats;
+	return formats;
+  }
+};
+
+#endif//CGCOURSEWORK_KTX_FILE_HPP
@@ -9,6 +9,7 @@
 #include <variant>
 #include <vector>
 #include "shader.hpp"
+#include "shader_permutations.hpp"
 
 class LightsManager {
 public:
@@ -136,9 +137,10 @@ private:
 public:
     void passDataToShader(Shader *shader) {
         shader->bind();
-        shader->setUniform1i("NUM_POINT_LIGHTS", pointLights.size());
-        shader->setUniform1i("NUM_SPOT_LIGHTS", spotLights.size());
-        shader->setUniform1i("NUM_DIR_LIGHTS", dirLights.size());
+        // permutations have light counts compiled in, asking the program itself would ask fallback() while it is pending
+        if (!shader->isDefined("NUM_POINT_LIGHTS")) shader->setUniform1i("NUM_POINT_LIGHTS", pointLights.size());
+        if (!shader->isDefined("NUM_SPOT_LIGHTS")) shader->setUniform1i("NUM_SPOT_LIGHTS", spotLights.size());
+        if (!shader->isDefined("NUM_DIR_LIGHTS")) shader->setUniform1i("NUM_DIR_LIGHTS", dirLights.size());
         for (int i = 0; i < dirLights.size(); ++i) {
             shader->setUniform3f("dirLights[" + std::to_string(i) + "].direction", dirLights[i].direction);
             shader->setUniform3f("dirLights[" + std::to_string(i) + "].diffuse", dirLights[i].diffuse);
@@ -171,6 +173,17 @@ public:
         }
     }
 
+    /**
+     * @brief permutation key with light counts of this manager, material part is left to the mesh
+     */
+    [[nodiscard]] ShaderPermutations::Key permutationKey() const {
+        ShaderPermutations::Key key;
+        key.dirLights = (int)dirLights.size();
+        key.pointLights = (int)pointLights.size();
+        key.spotLights = (int)spotLights.size();
+        return key;
+    }
+
     DirectionalLight *getDirLightByName(const std::string &name) {
         for (auto &dirLight:dirLights) {
             if (dirLight.name == name)return &dirLight;
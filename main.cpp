@@ -4,9 +4,20 @@
 
 #include "application.hpp"
 #include "camera.hpp"
+#include "camera_path.hpp"
+#include "cpu_profiler.hpp"
 #include "cube_map_texture.hpp"
+#include "frame_pacer.hpp"
+#include "frame_time_stats.hpp"
+#include "golden_image.hpp"
+#include "gpu_memory.hpp"
+#include "gpu_profiler.hpp"
 #include "lights_manager.hpp"
 #include "mesh.hpp"
+#include "simulation.hpp"
+#include "startup_timer.hpp"
+#include "texture_cache.hpp"
+#include "texture_loader.hpp"
 
 LightsManager *lightsManager;
 float lastX = 0;
@@ -16,7 +27,11 @@ bool firstMouse = true;
 double deltaTime = 0.0f;// time between current frame and last frame
 double lastFrame = 0.0f;
 Camera *camera;
-int pressedKey = -1;
+GpuProfiler *gpuProfiler;
+std::string gpuProfileFile;
+std::string gpuMemoryReportFile;
+Simulation::Input input;
+const float fanSpeed = 120;///< degrees per second
 
 template<typename Numeric, typename Generator = std::mt19937>
 [[maybe_unused]] Numeric random(Numeric from, Numeric to) {
@@ -48,20 +63,30 @@ template<typename Numeric, typename Generator = std::mt19937>
 }
 
 void programQuit([[maybe_unused]] int key, [[maybe_unused]] int action, Application *app) {
+  if (gpuProfiler != nullptr && gpuProfiler->isEnabled()) {
+	gpuProfiler->flush();// needs GL context, so it has to happen before window is destroyed
+	gpuProfiler->exportCsv(gpuProfileFile);
+  }
+  if (!gpuMemoryReportFile.empty()) GpuMemory::writeReport(gpuMemoryReportFile);
+  LOG_S(INFO) << TextureCache::summary();
+  TextureLoader::stop();
+  TextureCache::clear();
   app->close();
   LOG_S(INFO) << "Quiting...";
 }
 
 void wasdKeyPress([[maybe_unused]] int key, [[maybe_unused]] int action, [[maybe_unused]] Application *app) {
-  if (action == GLFW_PRESS) { pressedKey = key; }
-  if (action == GLFW_RELEASE) { pressedKey = -1; }
+  if (action == GLFW_PRESS) { input.pressedKey = key; }
+  if (action == GLFW_RELEASE) { input.pressedKey = -1; }
 }
 
-void moveCamera() {
-  if (pressedKey == GLFW_KEY_W) { camera->ProcessKeyboard(FORWARD, (float)deltaTime); }
-  if (pressedKey == GLFW_KEY_S) { camera->ProcessKeyboard(BACKWARD, (float)deltaTime); }
-  if (pressedKey == GLFW_KEY_A) { camera->ProcessKeyboard(LEFT, (float)deltaTime); }
-  if (pressedKey == GLFW_KEY_D) { camera->ProcessKeyboard(RIGHT, (float)deltaTime); }
+void moveCamera(Camera *movedCamera, float step) {
+  CPU_PROFILE_ZONE("moveCamera");
+  int pressedKey = input.pressedKey;
+  if (pressedKey == GLFW_KEY_W) { movedCamera->ProcessKeyboard(FORWARD, step); }
+  if (pressedKey == GLFW_KEY_S) { movedCamera->ProcessKeyboard(BACKWARD, step); }
+  if (pressedKey == GLFW_KEY_A) { movedCamera->ProcessKeyboard(LEFT, step); }
+  if (pressedKey == GLFW_KEY_D) { movedCamera->ProcessKeyboard(RIGHT, step); }
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -79,17 +104,20 @@ void mouse_callback([[maybe_unused]] GLFWwindow *window, double xpos, double ypo
   lastX = (float)xpos;
   lastY = (float)ypos;
 
-  camera->ProcessMouseMovement(xoffset, yoffset);
+  input.addMouseOffset(xoffset, yoffset);
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback([[maybe_unused]] GLFWwindow *window, [[maybe_unused]] double xoffset, double yoffset) {
-  camera->ProcessMouseScroll(yoffset);
+  input.addScrollOffset(yoffset);
 }
 void renderScene(Shader *shader, std::vector<Mesh *> meshes, std::vector<Plane *> planes);
 
 int main(int argc, char *argv[]) {
+  // zones are recorded only when trace was requested, startup is traced as well
+  std::string cpuTraceFile = getFlagValue(argc, argv, "--cpu-trace");
+  CpuProfiler::enable(!cpuTraceFile.empty());// also starts the clock time to first frame is measured with
   Application app({1280, 720}, argc, argv);
   Application::setOpenGLFlags();
   app.registerKeyCallback(GLFW_KEY_ESCAPE, programQuit);
@@ -104,21 +132,54 @@ int main(int argc, char *argv[]) {
 
   glCall(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
 
-  Shader shader("shaders/simple_shader.glsl", false);
-  shader.bind();
-  shader.setUniform1i("u_Texture", 0);
+  // linked programs are cached as driver binaries, so shaders are compiled only when they or the driver change
+  ProgramBinaryCache::enabled() = !isFlagPresent(argc, argv, "--no-program-cache");
+  ProgramBinaryCache::directory() = getFlagValue(argc, argv, "--program-cache", "cache/programs");
+  // programs are built by the driver while scene loads, fallback_shader.glsl draws in place of those that aren't ready.
+  // They aren't bound before the first frame: without GL_KHR_parallel_shader_compile the first bind waits for the build
+  bool syncShaders = isFlagPresent(argc, argv, "--sync-shaders");
+  if (!syncShaders) Shader::fallback() = new Shader("shaders/fallback_shader.glsl");
+  Shader shader = syncShaders ? Shader("shaders/simple_shader.glsl", false) : Shader("shaders/simple_shader.glsl", Shader::Deferred{});
+  Shader shader_skybox = syncShaders ? Shader("shaders/skybox_shader.glsl") : Shader("shaders/skybox_shader.glsl", Shader::Deferred{});
 
   std::vector<Mesh *> meshes;
   std::vector<Plane *> planes;
 
+  // imported models are cached in binary form, so assimp runs only when a model changes
+  MeshCache::enabled() = !isFlagPresent(argc, argv, "--no-mesh-cache");
+  MeshCache::directory() = getFlagValue(argc, argv, "--mesh-cache", "cache/meshes");
+  // --vertex-format float|packed|quantized, see Mesh::VertexFormat
+  Mesh::vertexFormat() = Mesh::vertexFormatFromString(getFlagValue(argc, argv, "--vertex-format", "packed"));
+  // levels of detail are drawn while their error is smaller than --lod-pixel-error pixels, 0 draws full detail only
+  Mesh::lodView().pixelError = std::stof(getFlagValue(argc, argv, "--lod-pixel-error", "1"));
+  // KTX files made by cook_textures target are used instead of images when they are up to date
+  Texture::useCooked(!isFlagPresent(argc, argv, "--no-cooked-textures"));
+  // textures are decoded on worker threads and bound as noTexture.png until they are uploaded
+  if (!isFlagPresent(argc, argv, "--sync-textures")) {
+	TextureLoader::start(TextureCache::acquire("textures/noTexture.png"),
+						 std::stoul(getFlagValue(argc, argv, "--texture-threads", "0")));
+  }
+
   // camera
   camera = new Camera(glm::vec3(0, 1, 0));
   camera->setWindowSize(app.getWindow()->getWindowSize());
 
-  glfwSetCursorPosCallback(app.getWindow()->getGLFWWindow(), mouse_callback);
-  glfwSetScrollCallback(app.getWindow()->getGLFWWindow(), scroll_callback);
-
-  double lasttime = glfwGetTime();
+  // benchmark replays camera path for fixed amount of frames without frame limiter
+  bool benchmark = isFlagPresent(argc, argv, "--benchmark");
+  long benchmarkFrames = std::stol(getFlagValue(argc, argv, "--benchmark-frames", "1000"));
+  std::string benchmarkReport = getFlagValue(argc, argv, "--benchmark-out", "benchmark.json");
+  std::string cameraPathFile = getFlagValue(argc, argv, "--camera-path");
+  std::string recordCameraPathFile = getFlagValue(argc, argv, "--record-camera-path");
+  CameraPath cameraPath = cameraPathFile.empty() ? CameraPath::scripted() : CameraPath(cameraPathFile);
+  CameraPath recordedCameraPath;
+  FrameTimeStats frameTimes;
+
+  app.getWindow()->setStatsLogging(isFlagPresent(argc, argv, "--stats-log") || app.getWindow()->isHeadless());
+
+  if (!benchmark) {
+	glfwSetCursorPosCallback(app.getWindow()->getGLFWWindow(), mouse_callback);
+	glfwSetScrollCallback(app.getWindow()->getGLFWWindow(), scroll_callback);
+  }
 
   // inner  room 1
   planes.push_back(new Plane({0, 0, 0}, {0, 2, 0}, {0, 2, -1}, {0, 0, -1}));//wall 1
@@ -239,34 +300,40 @@ int main(int argc, char *argv[]) {
   planes.push_back(new Plane({-6, 0.5, -17.499}, {-6, 1.5, -17.499}, {-5, 1.5, -17.499}, {-5, 0.5, -17.499}));
   planes.back()->setTexScale({1,1})->addTexture("textures/text.bmp")->setOrigin({-5.5, 1, -17.499})->setRotation({0, 0, 180});
 
+  // models are imported on --import-threads workers (0 is all cores) while textures above are decoded, meshes only upload them
+  MeshCache::preload({"resources/models/Crate1.obj", "resources/models/cylinder.obj", "resources/models/StreetLamp.obj",
+					  "resources/models/bench.blend", "resources/models/Fan.fbx"},
+					 std::stoul(getFlagValue(argc, argv, "--import-threads", "0")));
+
   //crates
   meshes.push_back(new Mesh("resources/models/Crate1.obj"));
   meshes.back()->setScale({0.5, 0.5, 0.5})->setPosition({5, 0.5, -3})->addTexture("textures/wood2.bmp");
-  meshes.push_back(new Mesh(meshes.back()->loadedOBJ));
-  meshes.back()->setTextures(meshes[0]->getTextures())->setScale({0.5, 0.5, 0.5})->setPosition({5, 0.5, -5});
-  meshes.push_back(new Mesh(meshes[0]->loadedOBJ));
-  meshes.back()->setTextures(meshes[0]->getTextures())->setScale({0.5, 0.5, 0.5})->setPosition({5, 0.5, -7});
-  meshes.push_back(new Mesh(meshes[0]->loadedOBJ));
-  meshes.back()->setTextures(meshes[0]->getTextures())->setScale({0.6, 0.6, 0.6})->setPosition({-13, 0.6, -16.7});
+  meshes.push_back(meshes[0]->instance());
+  meshes.back()->setScale({0.5, 0.5, 0.5})->setPosition({5, 0.5, -5});
+  meshes.push_back(meshes[0]->instance());
+  meshes.back()->setScale({0.5, 0.5, 0.5})->setPosition({5, 0.5, -7});
+  meshes.push_back(meshes[0]->instance());
+  meshes.back()->setScale({0.6, 0.6, 0.6})->setPosition({-13, 0.6, -16.7});
 
   //wall or smth idk
-  meshes.push_back(new Mesh(meshes[0]->loadedOBJ));
-  meshes.back()->setTextures(meshes[0]->getTextures())->setScale({0.1, 1, 3})->setPosition({0, 1, -5});
+  meshes.push_back(meshes[0]->instance());
+  meshes.back()->setScale({0.1, 1, 3})->setPosition({0, 1, -5});
 
   //pipes
   meshes.push_back(new Mesh("resources/models/cylinder.obj"));
   meshes.back()->setScale({0.5, 1, 0.5})->setPosition({5.4, 0, 5.2})->addTexture("textures/metal.bmp");
-  meshes.push_back(new Mesh(meshes[meshes.size() - 1]->loadedOBJ));
-  meshes.back()->setTextures(meshes[meshes.size() - 2]->getTextures())->setScale({0.5, 1, 0.5})->setPosition({-20, 0, -16.7});
+  auto *pipe = meshes.back();
+  meshes.push_back(pipe->instance());
+  meshes.back()->setScale({0.5, 1, 0.5})->setPosition({-20, 0, -16.7});
 
-  meshes.push_back(new Mesh(meshes[meshes.size() - 2]->loadedOBJ));
-  meshes.back()->setTextures(meshes[meshes.size() - 2]->getTextures())->setScale({0.5, 1, 0.5})->setPosition({5.3, 0, -16.7});
+  meshes.push_back(pipe->instance());
+  meshes.back()->setScale({0.5, 1, 0.5})->setPosition({5.3, 0, -16.7});
 
-  meshes.push_back(new Mesh(meshes[meshes.size() - 3]->loadedOBJ));
-  meshes.back()->setTextures(meshes[meshes.size() - 2]->getTextures())->setScale({0.5, 1, 0.5})->setPosition({-41.7, 0, -16.7});
+  meshes.push_back(pipe->instance());
+  meshes.back()->setScale({0.5, 1, 0.5})->setPosition({-41.7, 0, -16.7});
 
-  meshes.push_back(new Mesh(meshes[meshes.size() - 4]->loadedOBJ));
-  meshes.back()->setTextures(meshes[meshes.size() - 2]->getTextures())->setScale({0.5, 1, 0.5})->setPosition({-41.7, 0, 5.2});
+  meshes.push_back(pipe->instance());
+  meshes.back()->setScale({0.5, 1, 0.5})->setPosition({-41.7, 0, 5.2});
 
   meshes.push_back(new Mesh("resources/models/StreetLamp.obj"));
   meshes.back()->setPosition({-18, -0.001, 5.3})->setScale({0.15, 0.15, 0.15});
@@ -274,8 +341,8 @@ int main(int argc, char *argv[]) {
   meshes.back()->setPosition({-42, -0.001, -8})->setScale({0.15, 0.15, 0.15})->setOrigin({-42, -0.001, -8})->setRotation({0, 90, 0});
   meshes.push_back(new Mesh("resources/models/bench.blend"));
   meshes.back()->setRotation({270, 0, 180})->setPosition({-16.8, 0.3, 5.2})->setOrigin({-16.8, 0.3, 5.2})->setTextures({})->addTexture("textures/bench.png");
-  meshes.push_back(new Mesh(meshes.back()->loadedOBJ));
-  meshes.back()->setRotation({270, 0, 90})->setPosition({-41.5, 0.3, -9.4})->setOrigin({-41.5, 0.3, -9.4})->setTextures({})->addTexture("textures/bench.png");
+  meshes.push_back(meshes.back()->instance());
+  meshes.back()->setRotation({270, 0, 90})->setPosition({-41.5, 0.3, -9.4})->setOrigin({-41.5, 0.3, -9.4});
   meshes.push_back(new Mesh("resources/models/Fan.fbx"));
   meshes.back()->setScale({0.035, 0.035, 0.035})->setRotation({0, 0, 0})->setPosition({-5, 2, -4})->setOrigin({-5, 2, -4})->addTexture("textures/metal.bmp");
   meshes.push_back(new Mesh("resources/models/Fan.fbx"));
@@ -288,11 +355,6 @@ int main(int argc, char *argv[]) {
   }
 
 // Skybox
-  Shader shader_skybox("shaders/skybox_shader.glsl");
-  shader_skybox.bind();
-  shader_skybox.setUniform1i("skybox", 0);
-  shader_skybox.setUniform1f("intensity", 1);
-
   float skyboxVertices[] = {
       // positions
       -1.0f,  1.0f, -1.0f,
@@ -344,6 +406,7 @@ int main(int argc, char *argv[]) {
   glBindVertexArray(skyboxVAO);
   glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
   glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+  GpuMemory::track(GpuMemory::BUFFER, skyboxVBO, sizeof(skyboxVertices), "skybox");
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
@@ -359,51 +422,170 @@ int main(int argc, char *argv[]) {
       "textures/skybox/back.jpg"};
   unsigned int cubemapTexture = CubeMapTexture::loadCubemap(faces);
 
+  gpuProfileFile = getFlagValue(argc, argv, "--gpu-profile");
+  gpuMemoryReportFile = getFlagValue(argc, argv, "--gpu-memory-report");
+  gpuProfiler = new GpuProfiler(!gpuProfileFile.empty());
+
+  // renders whole scene from current camera, without swapping buffers
+  auto drawFrame = [&]() {
+	Renderer::clear({0, 0, 0, 1});
+	shader.bind();
+	shader.setUniform1i("u_Texture", 0);
+	camera->passDataToShader(&shader);
+	if (Mesh::lodView().pixelError > 0) Mesh::setLodView(camera->Position, camera->Zoom, camera->windowSize.y);
+	renderScene(&shader, meshes, planes);
+	// draw skybox as last, and only once its program is built: fallback() would draw the cube as a grey box in the scene
+	if (!shader_skybox.isReady()) return;
+	gpuProfiler->beginPass("skybox");
+	glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+	shader_skybox.bind();
+	shader_skybox.setUniform1i("skybox", 0);
+	shader_skybox.setUniform1f("intensity", 1);
+	auto view = glm::mat4(glm::mat3(camera->GetViewMatrix())); // remove translation from the view matrix
+	shader_skybox.setUniformMat4f("view", view);
+	shader_skybox.setUniformMat4f("projection", camera->getProjection());
+	// skybox cube
+	glBindVertexArray(skyboxVAO);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+	glDrawArrays(GL_TRIANGLES, 0, 36);
+	glBindVertexArray(0);
+	glDepthFunc(GL_LESS); // set depth function back to default
+	gpuProfiler->endPass();
+  };
+
+  // golden image test renders every pose of camera path, compares it with references and quits
+  std::string goldenDirectory = getFlagValue(argc, argv, "--golden");
+  if (!goldenDirectory.empty()) {
+	TextureLoader::finish();
+	shader.finish();
+	shader_skybox.finish();
+	// nothing draws with lighting_shader.glsl yet, so every variant the scene would ask for is built here to keep them linking,
+	// also with one light of each kind while the scene has none, so the light loops are compiled too
+	ShaderPermutations lighting("shaders/lighting_shader.glsl");
+	ShaderPermutations::Key sceneLights = lightsManager != nullptr ? lightsManager->permutationKey() : ShaderPermutations::Key{}, oneLight;
+	oneLight.dirLights = oneLight.pointLights = oneLight.spotLights = 1;
+	for (auto *mesh : meshes) {
+	  for (auto &lights : {sceneLights, oneLight}) {
+		for (auto &key : mesh->permutationKeys(lights)) lighting.get(key);
+	  }
+	}
+	bool permutationsLinked = lighting.finish();
+	LOG_S(INFO) << "Built " << lighting.size() << " variants of shaders/lighting_shader.glsl";
+	GoldenImageTest goldenTest(goldenDirectory,
+							   std::stoi(getFlagValue(argc, argv, "--golden-tolerance", "2")),
+							   std::stol(getFlagValue(argc, argv, "--golden-max-mismatched", "0")),
+							   std::stoi(getFlagValue(argc, argv, "--golden-repeats", "10")),
+							   isFlagPresent(argc, argv, "--golden-update"));
+	bool passed = goldenTest.run(app.getWindow(), camera, cameraPath, drawFrame) && permutationsLinked;
+	LOG_S(INFO) << "Golden image test " << (passed ? "passed" : "FAILED");
+	programQuit(GLFW_KEY_ESCAPE, GLFW_PRESS, &app);
+	glfwTerminate();
+	exit(passed ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  // there is no one to press ESC in headless mode, so it quits after given amount of frames
+  long framesLeft = std::stol(getFlagValue(argc, argv, "--frames", "600"));
+  long benchmarkFrame = 0;
+  bool isFirstFrame = true;
+  // benchmark is never limited, otherwise --fps-mode vsync|capped|uncapped, capped at --fps-cap
+  FramePacer pacer(benchmark ? FramePacer::UNCAPPED : FramePacer::modeFromString(getFlagValue(argc, argv, "--fps-mode", "capped")),
+				   std::stod(getFlagValue(argc, argv, "--fps-cap", "60")));
+  pacer.apply();
+  // simulation moves its own camera and fans, render loop only applies interpolated snapshots and draws
+  Camera simulationCamera = *camera;
+  size_t fanIndex = meshes.size() - 1;
+  Simulation::Snapshot initialState;
+  initialState.camera = Simulation::CameraPose::of(*camera);
+  for (auto *mesh : meshes) initialState.transforms.push_back(Simulation::Transform::of(*mesh));
+  Simulation simulation(initialState, std::stod(getFlagValue(argc, argv, "--sim-rate", "60")), [&](Simulation::Snapshot &state, double step) {
+	auto [mouseOffset, scrollOffset] = input.consume();
+	simulationCamera.ProcessMouseMovement(mouseOffset.x, mouseOffset.y);
+	if (scrollOffset != 0) simulationCamera.ProcessMouseScroll(scrollOffset);
+	moveCamera(&simulationCamera, (float)step);
+	state.camera = Simulation::CameraPose::of(simulationCamera);
+	auto &fan = state.transforms[fanIndex];
+	fan.rotation.y = std::fmod(fan.rotation.y + fanSpeed * (float)step, 360.f);
+	state.transforms[fanIndex - 1].rotation.y = fan.rotation.y + 1;
+  });
+  // benchmark has to render the same frames every run, so it is stepped from render loop
+  if (!benchmark && !isFlagPresent(argc, argv, "--single-thread")) simulation.start();
+  Simulation::Snapshot previousSnapshot, currentSnapshot;
+  if (benchmark) {
+	TextureLoader::finish();// benchmark measures rendering, not streaming
+	LOG_S(INFO) << "Benchmark: " << benchmarkFrames << " frames, camera path with " << cameraPath.size() << " keyframes";
+	frameTimes.reserve(benchmarkFrames);
+  }
+  lastFrame = glfwGetTime();
+
   // Runtime
   while (!app.getShouldClose()) {
+	CPU_PROFILE_ZONE("frame");
+	Renderer::newFrame();
 	app.getWindow()->updateFpsCounter();
+	gpuProfiler->beginFrame();
+	TextureLoader::poll();
 
 	auto currentFrame = glfwGetTime();
 	deltaTime = currentFrame - lastFrame;
 	lastFrame = currentFrame;
-	moveCamera();
+	// benchmark frames always advance simulation by one step so every run renders the same frames
+	if (!simulation.isThreaded()) simulation.advance(benchmark ? simulation.getStep() : deltaTime);
+	float alpha = simulation.latest(previousSnapshot, currentSnapshot);
+	if (benchmark) {
+	  cameraPath.apply(camera, (double)benchmarkFrame / (double)std::max(1L, benchmarkFrames - 1));
+	} else {
+	  Simulation::CameraPose::lerp(previousSnapshot.camera, currentSnapshot.camera, alpha).applyTo(camera);
+	}
+	for (size_t i = 0; i < meshes.size(); ++i) {
+	  meshes[i]->setModel(Simulation::Transform::lerp(previousSnapshot.transforms[i], currentSnapshot.transforms[i], alpha).getModel());
+	}
 
-	Renderer::clear({0, 0, 0, 1});
-	shader.bind();
-	camera->passDataToShader(&shader);
-	renderScene(&shader, meshes, planes);
-    // draw skybox as last
-    glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-    shader_skybox.bind();
-    shader_skybox.setUniform1f("intensity", 1);
-    auto view = glm::mat4(glm::mat3(camera->GetViewMatrix())); // remove translation from the view matrix
-    shader_skybox.setUniformMat4f("view", view);
-    shader_skybox.setUniformMat4f("projection", camera->getProjection());
-    // skybox cube
-    glBindVertexArray(skyboxVAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-    glDepthFunc(GL_LESS); // set depth function back to default
+	drawFrame();
 
+	gpuProfiler->beginPass("swap");
 	glCall(glfwSwapBuffers(app.getWindow()->getGLFWWindow()));
+	gpuProfiler->endPass();
+	if (isFirstFrame) {
+	  isFirstFrame = false;
+	  StartupTimer::logReport((double)CpuProfiler::now() / 1e6);
+	  std::string startupReport = getFlagValue(argc, argv, "--startup-report");
+	  if (!startupReport.empty()) StartupTimer::writeCsv(startupReport);
+	}
 	glfwPollEvents();
-	while (glfwGetTime() < lasttime + 1.0 / 60) {
-	  // TODO: Put the thread to sleep, yield, or simply do nothing
+	if (benchmark) {
+	  glFinish();// make sure GPU work of this frame is counted
+	  frameTimes.add((glfwGetTime() - currentFrame) * 1000.0);
+	  if (++benchmarkFrame >= benchmarkFrames) {
+		frameTimes.writeReport(benchmarkReport, getFlagValue(argc, argv, "--benchmark-label", "default"));
+		programQuit(GLFW_KEY_ESCAPE, GLFW_PRESS, &app);
+	  }
+	} else {
+	  if (!recordCameraPathFile.empty()) recordedCameraPath.addKeyframe(*camera);
+	  if (app.getWindow()->isHeadless() && --framesLeft <= 0) {
+		programQuit(GLFW_KEY_ESCAPE, GLFW_PRESS, &app);
+	  }
+	  pacer.wait();
 	}
-	lasttime += 1.0 / 60;
-	meshes[meshes.size() - 1]->setRotation(meshes[meshes.size() - 1]->rotation + glm::vec3(0, 2, 0));
-	meshes[meshes.size() - 2]->setRotation(meshes[meshes.size() - 1]->rotation + glm::vec3(0, 1, 0));
   }
+  simulation.stop();
+  if (!recordCameraPathFile.empty()) recordedCameraPath.save(recordCameraPathFile);
+  if (CpuProfiler::isEnabled()) CpuProfiler::exportChromeTrace(cpuTraceFile);
   glfwTerminate();
   exit(EXIT_SUCCESS);
 }
 void renderScene(Shader *shader, std::vector<Mesh *> meshes, std::vector<Plane *> planes) {
-  for (auto &plane : planes) {
-	plane->draw(shader);
+  CPU_PROFILE_ZONE("renderScene");
+  {
+	GpuProfiler::Scope scope(gpuProfiler, "planes");
+	for (auto &plane : planes) {
+	  plane->draw(shader);
+	}
   }
-  for (auto &mesh : meshes) {
-	mesh->draw(shader);
+  {
+	GpuProfiler::Scope scope(gpuProfiler, "meshes");
+	for (auto &mesh : meshes) {
+	  mesh->draw(shader);
+	}
   }
 }
\ No newline at end of file
@@ -13,34 +13,36 @@
 #include "Buffers/vertex_array.hpp"
 #include "Buffers/vertex_buffer.hpp"
 #include "color_buffer.hpp"
+#include "cpu_profiler.hpp"
 #include "functions.hpp"
+#include "geometry.hpp"
+#include "mesh_cache.hpp"
 #include "obj_loader.hpp"
 #include "plane.h"
 #include "renderer.hpp"
+#include "shader_permutations.hpp"
+#include "startup_timer.hpp"
 #include "texture.hpp"
+#include "texture_cache.hpp"
+#include "vertex_packing.hpp"
 
 class Mesh {
-  std::vector<float> coordinates;
-
   glm::mat4 model{};
 
-  std::vector<Buffer> buffers;
-  std::vector<Texture *> textures;
-  VertexArray *vao{nullptr};
-  unsigned int indexBufferSize{0};
-  IndexBuffer *indexBuffer{nullptr};
+  std::shared_ptr<Geometry> geometry;///< shared with every instance() of this mesh
+  TextureCache::References textures;
   std::vector<Mesh> relatedMeshes;
+  std::string name{"mesh"};///< owner of GPU memory of this mesh in GpuMemory report
 
   Mesh() = default;
 
   explicit Mesh(std::vector<glm::vec3> _coordinates) {
-	coordinates = vec3ArrayToFloatArray(std::move(_coordinates));
-	vao = new VertexArray;
+	geometry = std::make_shared<Geometry>(vec3ArrayToFloatArray(std::move(_coordinates)));
 	model = glm::mat4(1.f);
   }
 
   Mesh *setColor(const std::vector<glm::vec3> &colorsArray) {
-	if (colorsArray.size() * 3 != coordinates.size()) {
+	if (colorsArray.size() * 3 != geometry->coordinates.size()) {
 	  LOG_S(ERROR) << "Amount of elements in colorsArray(" << colorsArray.size() * 3
 				   << ") doesn't match amount vertices<<coordinates<<. Will still try to set colors but this may cause problems";
 	}
@@ -49,7 +51,7 @@ class Mesh {
   }
 
   Mesh *setColor(const std::vector<float> &colorsArray) {
-	if (colorsArray.size() != coordinates.size()) {
+	if (colorsArray.size() != geometry->coordinates.size()) {
 	  LOG_S(ERROR) << "Amount of elements in colorsArray(" << colorsArray.size()
 				   << ") doesn't match amount vertices<<coordinates<<. Will still try to set colors but this may cause problems";
 	}
@@ -58,14 +60,80 @@ class Mesh {
   }
 
  public:
+  /// how attributes are stored on GPU, float is 32 bytes per vertex, packed 20 and quantized 16
+  enum VertexFormat {
+	FLOAT,    ///< everything as 32 bit floats
+	PACKED,   ///< 2_10_10_10 normals, 16 bit normalized or half float texture coordinates
+	QUANTIZED,///< PACKED and 16 bit positions
+  };
+  /**
+   * @brief format meshes created from now on use, positions are converted in compile(), the rest when set
+   */
+  static VertexFormat &vertexFormat() {
+	static VertexFormat format{PACKED};
+	return format;
+  }
+  static VertexFormat vertexFormatFromString(const std::string &name) {
+	if (name == "float") return FLOAT;
+	if (name == "quantized") return QUANTIZED;
+	return PACKED;
+  }
+
+  /**
+   * @brief what level of detail selection needs to know about the view, see setLodView()
+   */
+  struct LodView {
+	glm::vec3 eye{0};
+	float pixelsPerUnit{0};///< projected size of one unit at distance of one unit, 0 disables levels of detail
+	float pixelError{1};   ///< coarsest level whose error projects to less than this many pixels is drawn
+  };
+  static LodView &lodView() {
+	static LodView view;
+	return view;
+  }
+  /**
+   * @brief updates view levels of detail are selected for, call it once per frame before drawing
+   * @param zoom vertical field of view in degrees (Camera::Zoom)
+   * @param viewportHeight in pixels
+   */
+  static void setLodView(glm::vec3 eye, float zoom, float viewportHeight) {
+	lodView().eye = eye;
+	lodView().pixelsPerUnit = viewportHeight / (2.f * std::tan(glm::radians(zoom) / 2.f));
+  }
+
+  static constexpr const char *noSpecularTexture = "textures/NoSpec.png";///< black specular map of meshes that have none
+
+  /**
+   * @brief shader variant this mesh needs, draw it with ShaderPermutations::get() of the result
+   * @param lights key with light counts, see LightsManager::permutationKey()
+   */
+  [[nodiscard]] ShaderPermutations::Key permutationKey(ShaderPermutations::Key lights) const {
+	lights.textured = !textures.empty();
+	if (lights.textured) {
+	  lights.specular = textures.size() == 2 && textures[1]->getFilepath() != noSpecularTexture;
+	} else {
+	  lights.specular = material.specular != glm::vec3(0);
+	}
+	return lights;
+  }
+  /**
+   * @brief permutationKey() of this mesh and of every mesh loaded with it, they are drawn with their own material
+   */
+  [[nodiscard]] std::vector<ShaderPermutations::Key> permutationKeys(const ShaderPermutations::Key &lights) const {
+	std::vector<ShaderPermutations::Key> keys{permutationKey(lights)};
+	for (auto &mesh : relatedMeshes) keys.push_back(mesh.permutationKey(lights));
+	return keys;
+  }
+
   glm::vec3 position{0, 0, 0};
   glm::vec3 origin{0, 0, 0};
   glm::vec3 rotation{0, 0, 0};
   glm::vec3 scale{1, 1, 1};
 
   Mesh *draw(Shader *shader) {
+	CPU_PROFILE_ZONE("Mesh::draw");
 	shader->bind();
-	shader->setUniformMat4f("model", model);
+	shader->setUniformMat4f("model", model * geometry->dequantization);
 	shader->setUniform1f("material.shininess", material.shininess);
 
 	if (!textures.empty()) {
@@ -83,10 +151,11 @@ class Mesh {
 	  shader->setUniform3f("material.mat_specular", material.specular);
 	  shader->setUniform3f("material.mat_ambient", material.ambient);
 	}
-	if (indexBuffer != nullptr) {
-	  Renderer::draw(indexBuffer, vao, shader, indexBufferSize, GL_TRIANGLES);
+	if (geometry->indexBuffer != nullptr) {
+	  auto *selected = selectLod();
+	  Renderer::draw(selected, &geometry->vao, shader, selected->getLength(), GL_TRIANGLES);
 	} else {
-	  Renderer::draw(vao, shader, coordinates.size() / 3, GL_TRIANGLES);
+	  Renderer::draw(&geometry->vao, shader, geometry->coordinates.size() / 3, GL_TRIANGLES);
 	}
 	for (auto &relatedMesh : relatedMeshes) {
 	  relatedMesh.draw(shader);
@@ -95,36 +164,45 @@ class Mesh {
   }
 
   explicit Mesh(std::vector<float> _coordinates) {
-	coordinates = std::move(_coordinates);
-	vao = new VertexArray;
+	geometry = std::make_shared<Geometry>(std::move(_coordinates));
 	model = glm::mat4(1.f);
   }
 
+  /**
+   * @brief loads model with all its meshes, geometry of a file that is already loaded is shared instead
+   */
   explicit Mesh(const std::string &filepath) {
-	ObjLoader objLoader;
-	auto meshes = objLoader.loadObj(filepath);
-	loadedOBJ = meshes.front();
-	coordinates = meshes.front().vertices;
-	setTextureCoords(meshes.front().texCoords);
-	setNormals(meshes.front().normals);
-	vao = new VertexArray;
-	material = loadedOBJ.material;
+	name = filepath;
+	model = glm::mat4(1.f);
+	geometry = Geometry::find(filepath);
+	if (geometry != nullptr) {
+	  material = geometry->material;
+	  for (int i = 1; auto part = Geometry::find(filepath + " #" + std::to_string(i)); ++i) {
+		Mesh related;
+		related.geometry = part;
+		related.material = part->material;
+		related.setTextures(related.material.textures)->setName(filepath + " #" + std::to_string(i))->compile();
+		relatedMeshes.push_back(std::move(related));
+	  }
+	  setTextures(material.textures);
+	  return;
+	}
+	auto meshes = MeshCache::loadObj(filepath);
+	StartupTimer::Scope timer(filepath, StartupTimer::UPLOAD);
+	setGeometry(meshes.front());
+	Geometry::share(filepath, geometry);
+	material = geometry->material;
 	for (int i = 1; i < meshes.size(); ++i) {
 	  relatedMeshes.emplace_back(meshes[i]);
-	  relatedMeshes.back().compile();
+	  relatedMeshes.back().setName(filepath + " #" + std::to_string(i))->compile();
+	  Geometry::share(relatedMeshes.back().getName(), relatedMeshes.back().geometry);
 	}
-	model = glm::mat4(1.f);
 	setTextures(material.textures);
   }
 
-  explicit Mesh(std::vector<ObjLoader::loadedOBJ> loadedOBJs) {
-	auto meshes = std::move(loadedOBJs);
-	loadedOBJ = meshes.front();
-	coordinates = meshes.front().vertices;
-	setTextureCoords(meshes.front().texCoords);
-	setNormals(meshes.front().normals);
-	vao = new VertexArray;
-	material = loadedOBJ.material;
+  explicit Mesh(const std::vector<ObjLoader::loadedOBJ> &meshes) {
+	setGeometry(meshes.front());
+	material = geometry->material;
 	for (int i = 1; i < meshes.size(); ++i) {
 	  relatedMeshes.emplace_back(meshes[i]);
 	  relatedMeshes.back().compile();
@@ -134,34 +212,49 @@ class Mesh {
   }
 
   explicit Mesh(const ObjLoader::loadedOBJ &loadedObjData) {
-	coordinates = loadedObjData.vertices;
-	setTextureCoords(loadedObjData.texCoords);
-	setNormals(loadedObjData.normals);
-	vao = new VertexArray;
+	setGeometry(loadedObjData);
 	model = glm::mat4(1.f);
-	material = loadedOBJ.material;
+	material = geometry->material;
 	setTextures(material.textures);
   }
 
-  ObjLoader::loadedOBJ loadedOBJ;
   ObjLoader::MaterialInfo material;
 
+  /**
+   * @brief another mesh drawing the same geometry, it only has its own transform, material and textures
+   * @details geometry is uploaded once for all instances, so texture coordinates, normals and colors set through
+   * any of them are seen by all of them
+   */
+  [[nodiscard]] Mesh *instance() const {
+	return new Mesh(*this);
+  }
+
   Mesh *compile() {
-	if (coordinates.empty()) {
+	if (geometry->coordinates.empty()) {
 	  LOG_S(ERROR) << "Coordinates were not set!";
 	  return this;
 	}
-	addNewBuffer(VertexBuffer(coordinates));// Setting VBO
+	bool upload = !geometry->compiled;
+	StartupTimer::Scope timer(name, StartupTimer::UPLOAD);
+	if (upload && vertexFormat() == QUANTIZED) {
+	  addNewBuffer(VertexBuffer(VertexPacking::quantizePositions(geometry->coordinates, geometry->dequantization)));
+	} else if (upload) {
+	  addNewBuffer(VertexBuffer(geometry->coordinates));// Setting VBO
+	}
+	if (upload) calculateBounds();
 	if (textures.size() == 1) {
-	  addTexture("textures/NoSpec.png");
+	  addTexture(noSpecularTexture);
+	}
+	if (upload) {
+	  fillVAO();
+	  geometry->compiled = true;
 	}
-	fillVAO();
 	return this;
   }
 
   Mesh *setColor(glm::vec3 color) {
 	std::vector<float> colors;
-	for (auto &coord : coordinates) {
+	for (auto &coord : geometry->coordinates) {
 	  colors.push_back(color.r);
 	  colors.push_back(color.g);
 	  colors.push_back(color.b);
@@ -171,11 +264,11 @@ class Mesh {
   }
 
   Mesh *addTexture(std::string filePath) {
-	textures.push_back(new Texture(filePath));
+	textures.push_back(TextureCache::acquire(filePath));
 	if (!wasBufferDefined(Buffer::TEXTURE_COORDS)) {
 	  LOG_S(INFO) << "Generating textureCoords";
-	  auto texCoords = Texture::generateTextureCoords(coordinates.size() / 3);
-	  addNewBuffer(TextureBuffer(texCoords));
+	  auto texCoords = Texture::generateTextureCoords(geometry->coordinates.size() / 3);
+	  setTextureCoords(texCoords);
 	}
 	for (auto &mesh : relatedMeshes) {
 	  mesh.setTextures(textures);
@@ -183,10 +276,10 @@ class Mesh {
 	return this;
   }
   Mesh *addScaledTexture(std::string filePath, glm::vec2 texScale) {
-	textures.push_back(new Texture(std::move(filePath)));
+	textures.push_back(TextureCache::acquire(filePath));
 	LOG_S(INFO) << "Generating textureCoords";
-	auto texCoords = Texture::generateTextureCoords(coordinates.size() / 3, {texScale.x, texScale.y});
-	addNewBuffer(TextureBuffer(texCoords), true);
+	auto texCoords = Texture::generateTextureCoords(geometry->coordinates.size() / 3, {texScale.x, texScale.y});
+	setTextureCoords(texCoords);
 	for (auto &mesh : relatedMeshes) {
 	  mesh.setTextures(textures);
 	}
@@ -194,19 +287,28 @@ class Mesh {
   }
 
   Mesh *setNormals(std::vector<glm::vec3> normals) {
-	addNewBuffer(NormalsBuffer(std::move(normals)), true);
-	return this;
+	return setNormals(vec3ArrayToFloatArray(std::move(normals)));
   }
 
   void generateNormals() {
+	setNormals(calculateNormals(geometry->coordinates));
+  }
+
+  /**
+   * @brief calculates flat normals for non-indexed triangles
+   * @param coordinates xyz of every vertex, 3 vertices per triangle
+   * @return one normal per vertex
+   */
+  static std::vector<glm::vec3> calculateNormals(const std::vector<float> &coordinates) {
 	auto vertices = floatArrayToVec3Array(coordinates);
 	std::vector<glm::vec3> normals{};
-	for (int i = 0; i < vertices.size(); ++i) {
-	  normals.push_back(calculateNormal(vertices[i], vertices[i + 1], vertices[i + 2]));
+	normals.reserve(vertices.size());
+	for (size_t i = 0; i + 2 < vertices.size(); i += 3) {
+	  auto normal = calculateNormal(vertices[i], vertices[i + 1], vertices[i + 2]);
+	  normals.insert(normals.end(), 3, normal);
 	}
-	// normals.push_back(glm::triangleNormal(vertices[vertices.size()-1], vertices[0], vertices[1]));
-
-	setNormals(normals);
+	normals.resize(vertices.size(), glm::vec3(0, 1, 0));// vertices that do not form full triangle
+	return normals;
   }
 
   static glm::vec3 calculateNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
@@ -218,23 +320,106 @@ class Mesh {
   }
 
   Mesh *setNormals(std::vector<float> normals) {
-	addNewBuffer(NormalsBuffer(std::move(normals)), true);
+	if (vertexFormat() == FLOAT) {
+	  addNewBuffer(NormalsBuffer(std::move(normals)), true);
+	} else {
+	  addNewBuffer(NormalsBuffer(VertexPacking::packNormals(normals)), true);
+	}
 	return this;
   }
 
   Mesh *setTextureCoords(std::vector<float> textureCoords) {
-	addNewBuffer(TextureBuffer(std::move(textureCoords)), true);
+	if (vertexFormat() == FLOAT) {
+	  addNewBuffer(TextureBuffer(std::move(textureCoords)), true);
+	} else {
+	  bool normalized;
+	  auto packed = VertexPacking::packTexCoords(textureCoords, normalized);
+	  addNewBuffer(TextureBuffer(packed, normalized), true);
+	}
 	return this;
   }
 
   void setIndices(std::vector<unsigned int> indices) {
-	indexBufferSize = indices.size();
-	indexBuffer = new IndexBuffer(indices);
+	geometry->indexBuffer = new IndexBuffer(indices);
+	GpuMemory::setOwner(GpuMemory::INDEX_BUFFER, geometry->indexBuffer->rendererID, name);
+  }
+
+  /**
+   * @brief sets simplified index lists, from finest to coarsest, needs indices to be set
+   */
+  Mesh *setLods(const std::vector<ObjLoader::LevelOfDetail> &levels) {
+	auto &lods = geometry->lods;
+	lods.clear();
+	if (geometry->indexBuffer == nullptr) return this;
+	for (auto &level : levels) {
+	  lods.push_back({new IndexBuffer(level.indices), level.error});
+	  GpuMemory::setOwner(GpuMemory::INDEX_BUFFER, lods.back().indexBuffer->rendererID, name);
+	}
+	return this;
+  }
+
+  /**
+   * @brief sets name GPU memory of this mesh is reported under
+   */
+  Mesh *setName(std::string _name) {
+	name = std::move(_name);
+	geometry->setOwner(name);
+	return this;
+  }
+
+  [[nodiscard]] const std::string &getName() const {
+	return name;
   }
 
  private:
+  /**
+   * @brief new geometry with every attribute of loaded mesh, positions are uploaded in compile()
+   */
+  void setGeometry(const ObjLoader::loadedOBJ &loaded) {
+	geometry = std::make_shared<Geometry>(loaded.vertices);
+	geometry->material = loaded.material;
+	setTextureCoords(loaded.texCoords);
+	setNormals(loaded.normals);
+	if (!loaded.indices.empty()) setIndices(loaded.indices);
+	setLods(loaded.lods);
+  }
+
+  void calculateBounds() {
+	auto &coordinates = geometry->coordinates;
+	glm::vec3 min{INFINITY}, max{-INFINITY};
+	for (size_t i = 0; i + 2 < coordinates.size(); i += 3) {
+	  glm::vec3 vertex{coordinates[i], coordinates[i + 1], coordinates[i + 2]};
+	  min = glm::min(min, vertex);
+	  max = glm::max(max, vertex);
+	}
+	geometry->boundsCenter = (min + max) / 2.f;
+	geometry->boundsRadius = glm::length(max - min) / 2.f;
+  }
+
+  /**
+   * @brief picks coarsest level whose error projected from bounds nearest to the eye is under LodView::pixelError
+   */
+  IndexBuffer *selectLod() {
+	auto &view = lodView();
+	auto &lods = geometry->lods;
+	auto *indexBuffer = geometry->indexBuffer;
+	if (lods.empty() || view.pixelsPerUnit <= 0) return indexBuffer;
+	float scale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))});
+	float distance = glm::distance(glm::vec3(model * glm::vec4(geometry->boundsCenter, 1)), view.eye) - geometry->boundsRadius * scale;
+	if (distance <= 0) return indexBuffer;
+	float pixelsPerUnit = view.pixelsPerUnit * scale / distance;
+	IndexBuffer *selected = indexBuffer;
+	for (auto &lod : lods) {
+	  if (lod.error * pixelsPerUnit >= view.pixelError) break;
+	  selected = lod.indexBuffer;
+	}
+	return selected;
+  }
+
   Mesh *addNewBuffer(Buffer _buffer, bool bReplace = false) {
+	GpuMemory::setOwner(GpuMemory::BUFFER, _buffer.rendererID, name);
 	bool wasReplaced = false;
+	auto &buffers = geometry->buffers;
 	for (auto &buffer : buffers) {
 	  if (_buffer.bufferType == buffer.bufferType && buffer.bufferType != Buffer::OTHER) {
 		if (bReplace) {
@@ -255,24 +440,16 @@ class Mesh {
 	if (!wasBufferDefined(Buffer::NORMAL)) {
 	  generateNormals();
 	}
-	VertexBufferLayout layout3;
-	VertexBufferLayout layout2;
-	layout3.push<float>(3);///< number of params for each vertex
-	layout2.push<float>(2);///< number of params for each vertex
-	for (auto &buffer : buffers) {
+	for (auto &buffer : geometry->buffers) {
 	  if (buffer.bufferType != Buffer::type::INDEX && buffer.bufferType != Buffer::type::OTHER) {// We skip indexBuffer
-		if (buffer.bufferType == Buffer::type::TEXTURE_COORDS) {
-		  vao->addBuffer(buffer, layout2, buffer.attributeLocation);
-		} else {
-		  vao->addBuffer(buffer, layout3, buffer.attributeLocation);
-		}
+		geometry->vao.addBuffer(buffer, buffer.layout, buffer.attributeLocation);
 	  }
 	}
 	return this;
   }
 
   bool wasBufferDefined(Buffer::type bufferType) {
-	for (auto &buffer : buffers) {
+	for (auto &buffer : geometry->buffers) {
 	  if (bufferType == buffer.bufferType) {
 		return true;
 	  }
@@ -281,7 +458,7 @@ class Mesh {
   }
 
   Buffer *getBufferOfType(Buffer::type bufferType) {
-	for (auto &buffer : buffers) {
+	for (auto &buffer : geometry->buffers) {
 	  if (bufferType == buffer.bufferType) {
 		return &buffer;
 	  }
@@ -327,22 +504,42 @@ class Mesh {
 	return this;
   }
 
+  /**
+   * @brief sets model matrix directly, position/rotation/scale are left as they are
+   */
+  Mesh *setModel(const glm::mat4 &_model) {
+	model = _model;
+	for (auto &mesh : relatedMeshes) {
+	  mesh.setModel(model);
+	}
+	return this;
+  }
+
   Mesh *updateModel() {
-	model = glm::mat4(1.f);
+	model = calculateModel(position, origin, rotation, scale);
+	return this;
+  }
+
+  /**
+   * @brief builds model matrix: rotation (in degrees, x then y then z) is done around origin
+   * @return model matrix
+   */
+  static glm::mat4 calculateModel(glm::vec3 position, glm::vec3 origin, glm::vec3 rotation, glm::vec3 scale) {
+	glm::mat4 model = glm::mat4(1.f);
 	model = glm::translate(model, origin);
-	model = glm::rotate(model, glm::radians(this->rotation.x), glm::vec3(1.f, 0.f, 0.f));
-	model = glm::rotate(model, glm::radians(this->rotation.y), glm::vec3(0.f, 1.f, 0.f));
-	model = glm::rotate(model, glm::radians(this->rotation.z), glm::vec3(0.f, 0.f, 1.f));
+	model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.f, 0.f, 0.f));
+	model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.f, 1.f, 0.f));
+	model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.f, 0.f, 1.f));
 	model = glm::translate(model, position - origin);
 	model = glm::scale(model, scale);
-	return this;
+	return model;
   }
 
-  std::vector<Texture *> getTextures() {
+  TextureCache::References getTextures() {
 	return textures;
   }
 
-  Mesh *setTextures(std::vector<Texture *> _textures) {
+  Mesh *setTextures(TextureCache::References _textures) {
 	textures = std::move(_textures);
 	return this;
   }
@@ -0,0 +1,358 @@
+#ifndef CGCOURSEWORK_MESH_CACHE_HPP
+#define CGCOURSEWORK_MESH_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cpu_profiler.hpp"
+#include "functions.hpp"
+#include "obj_loader.hpp"
+#include "startup_timer.hpp"
+#include "texture_cache.hpp"
+
+/**
+ * @brief caches result of ObjLoader in a flat binary file, so later launches don't run assimp at all
+ * @details cache file is keyed by source path and valid only for the same source content (FNV-1a hash and size
+ * of the .obj and of every .mtl it names with mtllib, since materials and texture paths come from those),
+ * import flags and layout version. Layout is a header, a table of meshes and 8 byte aligned arrays referenced
+ * by offsets from the start of file, so it is read by mapping it to memory. Textures are stored as paths
+ * and acquired from TextureCache on load.
+ */
+class MeshCache {
+ public:
+  static constexpr uint32_t version = 6;///< bump when layout or ObjLoader output changes
+
+ private:
+  struct Span {
+	uint64_t offset;///< bytes from start of file
+	uint64_t count; ///< elements
+  };
+  struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t importFlags;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint64_t meshCount;///< MeshRecord array follows header
+  };
+  struct MeshRecord {
+	Span vertices, texCoords, normals, indices;
+	Span name;        ///< chars
+	Span texturePaths;///< Span of chars for every path
+	Span lods;        ///< LodRecord for every level of detail
+	float ambient[3], diffuse[3], specular[3], shininess;
+  };
+  struct LodRecord {
+	Span indices;
+	float error;
+	uint32_t padding;
+  };
+  static constexpr char magic[8]{'V', 'L', 'M', 'E', 'S', 'H', 0, 0};
+
+  /**
+   * @brief read only view of whole file, mapped where mmap is available
+   */
+  class Mapping {
+	const unsigned char *bytes{nullptr};
+	size_t length{0};
+#if defined(__APPLE__) || defined(__linux__)
+	void *address{MAP_FAILED};
+#else
+	std::vector<unsigned char> buffer;
+#endif
+
+   public:
+	explicit Mapping(const std::string &filepath) {
+#if defined(__APPLE__) || defined(__linux__)
+	  int descriptor = open(filepath.c_str(), O_RDONLY);
+	  if (descriptor < 0) return;
+	  struct stat info {};
+	  if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+		address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (address != MAP_FAILED) {
+		  bytes = (const unsigned char *)address;
+		  length = (size_t)info.st_size;
+		}
+	  }
+	  close(descriptor);
+#else
+	  buffer = readBinaryFile(filepath);
+	  bytes = buffer.data();
+	  length = buffer.size();
+#endif
+	}
+	~Mapping() {
+#if defined(__APPLE__) || defined(__linux__)
+	  if (address != MAP_FAILED) munmap(address, length);
+#endif
+	}
+	Mapping(const Mapping &) = delete;
+	Mapping &operator=(const Mapping &) = delete;
+
+	[[nodiscard]] const unsigned char *data() const { return bytes; }
+	[[nodiscard]] size_t size() const { return length; }
+	/**
+	 * @brief pointer to span of elements of type T, nullptr if span is out of file
+	 */
+	template<typename T>
+	[[nodiscard]] const T *get(const Span &span) const {
+	  if (span.offset % alignof(T) != 0 || span.offset > length || span.count > (length - span.offset) / sizeof(T)) return nullptr;
+	  return (const T *)(bytes + span.offset);
+	}
+  };
+
+ public:
+  /**
+   * @brief directory cache files are written to, relative to working directory
+   */
+  static std::string &directory() {
+	static std::string path{"cache/meshes"};
+	return path;
+  }
+  static bool &enabled() {
+	static bool value{true};
+	return value;
+  }
+
+  /**
+   * @brief same as ObjLoader::loadObj(), but result is taken from cache when it is up to date
+   * @details models imported by preload() are taken from memory, only their textures are acquired here
+   */
+  static std::vector<ObjLoader::loadedOBJ> loadObj(const std::string &filepath) {
+	std::vector<ObjLoader::loadedOBJ> meshes;
+	auto found = preloaded().find(cachePathFor(filepath));
+	if (found != preloaded().end()) {
+	  meshes = std::move(found->second);
+	  preloaded().erase(found);
+	} else {
+	  Assimp::Importer importer;
+	  meshes = import(filepath, importer);
+	}
+	ObjLoader::acquireTextures(meshes);
+	return meshes;
+  }
+
+  /**
+   * @brief imports models on worker threads ahead of loadObj() calls that take them
+   * @details every path is imported once however many times it is listed. Each worker reads cache or runs assimp
+   * with its own Assimp::Importer, nothing touches GL until loadObj() acquires textures and Mesh uploads buffers.
+   * Returns when every model is imported.
+   * @param threads workers including calling thread, 0 to use all cores
+   */
+  static void preload(const std::vector<std::string> &filepaths, unsigned int threads = 0) {
+	CPU_PROFILE_ZONE("MeshCache::preload");
+	std::vector<std::string> unique;
+	std::vector<std::string> keys;
+	for (auto &filepath : filepaths) {
+	  auto key = cachePathFor(filepath);
+	  if (std::find(keys.begin(), keys.end(), key) != keys.end() || preloaded().count(key) != 0) continue;
+	  keys.push_back(key);
+	  unique.push_back(filepath);
+	}
+	if (unique.empty()) return;
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min(threads, (unsigned int)unique.size());
+
+	std::vector<std::vector<ObjLoader::loadedOBJ>> results(unique.size());
+	std::atomic<size_t> next{0};
+	auto work = [&] {
+	  Assimp::Importer importer;
+	  for (size_t i = next++; i < unique.size(); i = next++) results[i] = import(unique[i], importer);
+	};
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threads; ++i) workers.emplace_back(work);
+	work();
+	for (auto &worker : workers) worker.join();
+	for (size_t i = 0; i < unique.size(); ++i) preloaded()[keys[i]] = std::move(results[i]);
+	LOG_S(INFO) << "Preloaded " << unique.size() << " models of " << filepaths.size() << " requested on " << threads << " threads";
+  }
+
+ private:
+  /// models imported by preload() and not taken yet, by cache path
+  static std::map<std::string, std::vector<ObjLoader::loadedOBJ>> &preloaded() {
+	static std::map<std::string, std::vector<ObjLoader::loadedOBJ>> models;
+	return models;
+  }
+
+  /**
+   * @brief reads cache or imports and writes it, textures are not acquired, so it runs on any thread
+   */
+  static std::vector<ObjLoader::loadedOBJ> import(const std::string &filepath, Assimp::Importer &importer) {
+	if (!enabled()) return ObjLoader().loadObj(filepath, importer);
+	CPU_PROFILE_ZONE("MeshCache::import");
+	uint64_t sourceHash, sourceSize;
+	{
+	  StartupTimer::Scope timer(filepath, StartupTimer::READ);
+	  auto source = readBinaryFile(filepath);
+	  sourceHash = hashBytes(source.data(), source.size());
+	  sourceSize = source.size();
+	  for (auto &library : materialLibraries(filepath, source)) {
+		auto material = readBinaryFile(library);
+		// separator keeps moving bytes between files from giving the same hash, missing library hashes as empty
+		sourceHash = hashBytes(library.data(), library.size() + 1, sourceHash);
+		sourceHash = hashBytes(material.data(), material.size(), sourceHash);
+		sourceSize += material.size();
+	  }
+	}
+	std::string cachePath = cachePathFor(filepath);
+	std::vector<ObjLoader::loadedOBJ> meshes;
+	{
+	  StartupTimer::Scope timer(filepath, StartupTimer::READ);
+	  meshes = read(cachePath, sourceHash, sourceSize);
+	}
+	if (!meshes.empty()) {
+	  LOG_S(INFO) << "Loaded " << filepath << " from mesh cache " << cachePath;
+	  return meshes;
+	}
+	meshes = ObjLoader().loadObj(filepath, importer);
+	if (!meshes.empty() && !write(cachePath, sourceHash, sourceSize, meshes)) {
+	  LOG_S(WARNING) << "Unable to write mesh cache " << cachePath;
+	}
+	return meshes;
+  }
+
+  /**
+   * @return paths of material libraries listed on mtllib lines, relative to the .obj like assimp resolves them
+   */
+  static std::vector<std::string> materialLibraries(const std::string &filepath, const std::vector<unsigned char> &source) {
+	std::vector<std::string> libraries;
+	auto directory = std::filesystem::path(filepath).parent_path();
+	std::istringstream stream(std::string(source.begin(), source.end()));
+	for (std::string line; std::getline(stream, line);) {
+	  size_t start = line.find_first_not_of(" \t");
+	  if (start == std::string::npos || line.compare(start, 7, "mtllib ") != 0) continue;
+	  size_t begin = line.find_first_not_of(" \t", start + 7);
+	  size_t end = line.find_last_not_of(" \t\r");
+	  if (begin == std::string::npos || end < begin) continue;
+	  libraries.push_back((directory / line.substr(begin, end - begin + 1)).string());
+	}
+	return libraries;
+  }
+
+  static std::string cachePathFor(const std::string &filepath) {
+	std::error_code error;
+	auto canonical = std::filesystem::weakly_canonical(filepath, error).string();
+	std::ostringstream name;
+	name << std::filesystem::path(filepath).filename().string() << "-" << std::hex << std::setw(16) << std::setfill('0')
+		 << hashBytes(canonical.data(), canonical.size()) << ".vlmesh";
+	return (std::filesystem::path(directory()) / name.str()).string();
+  }
+
+  /**
+   * @return empty vector if there is no valid cache for this source
+   */
+  static std::vector<ObjLoader::loadedOBJ> read(const std::string &cachePath, uint64_t sourceHash, uint64_t sourceSize) {
+	Mapping file(cachePath);
+	if (file.size() < sizeof(Header)) return {};
+	auto *header = (const Header *)file.data();
+	if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version || header->importFlags != ObjLoader::importFlags ||
+		header->sourceHash != sourceHash || header->sourceSize != sourceSize) {
+	  LOG_S(INFO) << "Mesh cache " << cachePath << " is out of date";
+	  return {};
+	}
+	auto *records = file.get<MeshRecord>({sizeof(Header), header->meshCount});
+	if (records == nullptr) return corrupted(cachePath);
+	std::vector<ObjLoader::loadedOBJ> meshes(header->meshCount);
+	for (size_t i = 0; i < meshes.size(); ++i) {
+	  auto &record = records[i];
+	  auto &mesh = meshes[i];
+	  if (!copy(file, record.vertices, mesh.vertices) || !copy(file, record.texCoords, mesh.texCoords) ||
+		  !copy(file, record.normals, mesh.normals) || !copy(file, record.indices, mesh.indices)) return corrupted(cachePath);
+	  auto *name = file.get<char>(record.name);
+	  auto *paths = file.get<Span>(record.texturePaths);
+	  auto *lods = file.get<LodRecord>(record.lods);
+	  if (name == nullptr || paths == nullptr || lods == nullptr) return corrupted(cachePath);
+	  mesh.lods.resize(record.lods.count);
+	  for (size_t j = 0; j < mesh.lods.size(); ++j) {
+		if (!copy(file, lods[j].indices, mesh.lods[j].indices)) return corrupted(cachePath);
+		mesh.lods[j].error = lods[j].error;
+	  }
+	  auto &material = mesh.material;
+	  material.name.assign(name, record.name.count);
+	  material.ambient = glm::make_vec3(record.ambient);
+	  material.diffuse = glm::make_vec3(record.diffuse);
+	  material.specular = glm::make_vec3(record.specular);
+	  material.shininess = record.shininess;
+	  for (size_t j = 0; j < record.texturePaths.count; ++j) {
+		auto *path = file.get<char>(paths[j]);
+		if (path == nullptr) return corrupted(cachePath);
+		material.texturePaths.emplace_back(path, paths[j].count);
+	  }
+	}
+	return meshes;
+  }
+
+  static std::vector<ObjLoader::loadedOBJ> corrupted(const std::string &cachePath) {
+	LOG_S(WARNING) << "Mesh cache " << cachePath << " is corrupted, model will be imported again";
+	return {};
+  }
+
+  template<typename T>
+  static bool copy(const Mapping &file, const Span &span, std::vector<T> &destination) {
+	auto *source = file.get<T>(span);
+	if (source == nullptr) return false;
+	destination.assign(source, source + span.count);
+	return true;
+  }
+
+  static bool write(const std::string &cachePath, uint64_t sourceHash, uint64_t sourceSize, const std::vector<ObjLoader::loadedOBJ> &meshes) {
+	std::vector<unsigned char> file(sizeof(Header) + sizeof(MeshRecord) * meshes.size());
+	auto append = [&file](const void *data, size_t bytes, uint64_t count) {
+	  file.resize((file.size() + 7) & ~(size_t)7);
+	  Span span{file.size(), count};
+	  file.insert(file.end(), (const unsigned char *)data, (const unsigned char *)data + bytes);
+	  return span;
+	};
+	std::vector<MeshRecord> records(meshes.size());
+	for (size_t i = 0; i < meshes.size(); ++i) {
+	  auto &mesh = meshes[i];
+	  auto &record = records[i];
+	  record.vertices = append(mesh.vertices.data(), mesh.vertices.size() * sizeof(float), mesh.vertices.size());
+	  record.texCoords = append(mesh.texCoords.data(), mesh.texCoords.size() * sizeof(float), mesh.texCoords.size());
+	  record.normals = append(mesh.normals.data(), mesh.normals.size() * sizeof(float), mesh.normals.size());
+	  record.indices = append(mesh.indices.data(), mesh.indices.size() * sizeof(mesh.indices[0]), mesh.indices.size());
+	  record.name = append(mesh.material.name.data(), mesh.material.name.size(), mesh.material.name.size());
+	  std::vector<Span> paths;
+	  for (auto &path : mesh.material.texturePaths) paths.push_back(append(path.data(), path.size(), path.size()));
+	  record.texturePaths = append(paths.data(), paths.size() * sizeof(Span), paths.size());
+	  std::vector<LodRecord> lods;
+	  for (auto &lod : mesh.lods) {
+		lods.push_back({append(lod.indices.data(), lod.indices.size() * sizeof(lod.indices[0]), lod.indices.size()), lod.error, 0});
+	  }
+	  record.lods = append(lods.data(), lods.size() * sizeof(LodRecord), lods.size());
+	  std::memcpy(record.ambient, &mesh.material.ambient, sizeof(record.ambient));
+	  std::memcpy(record.diffuse, &mesh.material.diffuse, sizeof(record.diffuse));
+	  std::memcpy(record.specular, &mesh.material.specular, sizeof(record.specular));
+	  record.shininess = mesh.material.shininess;
+	}
+	Header header{};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.importFlags = ObjLoader::importFlags;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.meshCount = meshes.size();
+	std::memcpy(file.data(), &header, sizeof(header));
+	std::memcpy(file.data() + sizeof(Header), records.data(), sizeof(MeshRecord) * records.size());
+
+	return writeFileAtomically(cachePath, file);
+  }
+};
+
+#endif//CGCOURSEWORK_MESH_CACHE_HPP
@@ -0,0 +1,230 @@
+#ifndef CGCOURSEWORK_MESH_OPTIMIZER_HPP
+#define CGCOURSEWORK_MESH_OPTIMIZER_HPP
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "functions.hpp"
+
+/**
+ * @brief reorders indexed triangle lists for GPU vertex processing, everything here works on CPU only
+ * @details vertex cache order is Tipsify (Sander, Nehab, Barczak 2007), overdraw order sorts clusters of that
+ * order front to back so outer surfaces are drawn first, fetch order renumbers vertices in order of first use.
+ * Run them in this order, every step keeps what previous ones achieved.
+ */
+class MeshOptimizer {
+ public:
+  static constexpr unsigned int cacheSize = 16;///< FIFO post transform cache that is optimized for and simulated
+
+  struct Statistics {
+	float acmr{0};///< average cache miss ratio, transformed vertices per triangle, 0.5 is ideal, 3 is worst
+	float atvr{0};///< average transformed to vertex ratio, transformed vertices per unique vertex, 1 is ideal
+  };
+
+  /**
+   * @brief simulates FIFO post transform cache of given size
+   */
+  static Statistics analyzeVertexCache(const std::vector<uint> &indices, size_t vertexCount, unsigned int size = cacheSize) {
+	Statistics statistics;
+	if (indices.empty()) return statistics;
+	std::vector<unsigned int> cachedAt(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	unsigned int timestamp = size + 1, misses = 0, unique = 0;
+	for (auto index : indices) {
+	  if (timestamp - cachedAt[index] > size) {
+		cachedAt[index] = timestamp++;
+		misses++;
+	  }
+	  if (!used[index]) used[index] = true, unique++;
+	}
+	statistics.acmr = (float)misses / (float)(indices.size() / 3);
+	statistics.atvr = (float)misses / (float)unique;
+	return statistics;
+  }
+
+  /**
+   * @brief Tipsify: fans triangles around vertices that are still in cache, jumps to a dead end vertex when none is
+   */
+  static std::vector<uint> optimizeVertexCache(const std::vector<uint> &indices, size_t vertexCount, unsigned int size = cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	// triangles adjacent to every vertex, as offsets into one array
+	std::vector<unsigned int> live(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(indices.size());
+	for (auto index : indices) live[index]++;
+	for (size_t i = 0; i < vertexCount; ++i) offsets[i + 1] = offsets[i] + live[i];
+	std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i) adjacency[filled[indices[i]]++] = (unsigned int)(i / 3);
+
+	std::vector<uint> result;
+	result.reserve(indices.size());
+	std::vector<unsigned int> cachedAt(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnds, candidates;
+	unsigned int timestamp = size + 1;
+	size_t cursor = 0;
+	long fanning = vertexCount > 0 ? 0 : -1;
+	while (fanning >= 0) {
+	  candidates.clear();
+	  for (auto i = offsets[fanning]; i < offsets[fanning + 1]; ++i) {
+		auto triangle = adjacency[i];
+		if (emitted[triangle]) continue;
+		for (int corner = 0; corner < 3; ++corner) {
+		  auto vertex = indices[triangle * 3 + corner];
+		  result.push_back(vertex);
+		  deadEnds.push_back(vertex);
+		  candidates.push_back(vertex);
+		  live[vertex]--;
+		  if (timestamp - cachedAt[vertex] > size) cachedAt[vertex] = timestamp++;
+		}
+		emitted[triangle] = true;
+	  }
+	  // prefers vertex that entered cache earliest but will still be there after its remaining triangles are emitted
+	  fanning = -1;
+	  long best = -1;
+	  for (auto vertex : candidates) {
+		if (live[vertex] == 0) continue;
+		long priority = 0;
+		if (timestamp - cachedAt[vertex] + 2 * live[vertex] <= size) priority = timestamp - cachedAt[vertex];
+		if (priority > best) best = priority, fanning = vertex;
+	  }
+	  if (fanning < 0) fanning = skipDeadEnd(deadEnds, live, cursor);
+	}
+	return result;
+  }
+
+  /**
+   * @brief splits vertex cache ordered triangles to clusters and draws clusters facing out of the mesh first
+   * @details cluster ends where simulated cache is flushed, and is split further wherever its ACMR so far is within
+   * threshold of whole cluster's ACMR, so reordering clusters costs at most that much of cache efficiency
+   * @param positions 3 floats per vertex
+   * @param threshold allowed ACMR increase, 1.05 means 5%
+   */
+  static std::vector<uint> optimizeOverdraw(const std::vector<uint> &indices, const std::vector<float> &positions, float threshold = 1.05f,
+											unsigned int size = cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2) return indices;
+	size_t vertexCount = positions.size() / 3;
+	std::vector<unsigned int> cachedAt(vertexCount, 0);
+	unsigned int timestamp = size + 1;
+	auto misses = [&](size_t triangle) {
+	  unsigned int result = 0;
+	  for (int corner = 0; corner < 3; ++corner) {
+		auto vertex = indices[triangle * 3 + corner];
+		if (timestamp - cachedAt[vertex] > size) cachedAt[vertex] = timestamp++, result++;
+	  }
+	  return result;
+	};
+	auto flush = [&] { timestamp += size + 1; };
+
+	std::vector<size_t> hard{0};
+	for (size_t i = 0; i < triangleCount; ++i) {
+	  if (misses(i) == 3 && i > 0) hard.push_back(i);
+	}
+	hard.push_back(triangleCount);
+
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c + 1 < hard.size(); ++c) {
+	  size_t start = hard[c], end = hard[c + 1];
+	  flush();
+	  unsigned int clusterMisses = 0;
+	  for (size_t i = start; i < end; ++i) clusterMisses += misses(i);
+	  float clusterThreshold = threshold * (float)clusterMisses / (float)(end - start);
+	  flush();
+	  clusters.push_back(start);
+	  unsigned int runningMisses = 0, runningTriangles = 0;
+	  for (size_t i = start; i + 1 < end; ++i) {
+		runningMisses += misses(i);
+		runningTriangles++;
+		if ((float)runningMisses / (float)runningTriangles <= clusterThreshold) {
+		  clusters.push_back(i + 1);
+		  flush();
+		  runningMisses = runningTriangles = 0;
+		}
+	  }
+	}
+	clusters.push_back(triangleCount);
+
+	// area weighted centroid and normal of every cluster, sorted by how much it faces away from mesh center
+	auto position = [&](uint vertex) { return glm::vec3(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]); };
+	glm::vec3 meshCentroid{0};
+	float meshArea = 0;
+	std::vector<glm::vec3> centroids(clusters.size() - 1, glm::vec3(0)), normals(clusters.size() - 1, glm::vec3(0));
+	std::vector<float> areas(clusters.size() - 1, 0);
+	for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+	  for (size_t i = clusters[c]; i < clusters[c + 1]; ++i) {
+		glm::vec3 a = position(indices[i * 3]), b = position(indices[i * 3 + 1]), d = position(indices[i * 3 + 2]);
+		glm::vec3 normal = glm::cross(b - a, d - a);
+		float area = glm::length(normal);
+		centroids[c] += (a + b + d) / 3.f * area;
+		normals[c] += normal;
+		areas[c] += area;
+	  }
+	  meshCentroid += centroids[c];
+	  meshArea += areas[c];
+	  if (areas[c] > 0) centroids[c] /= areas[c];
+	}
+	if (meshArea > 0) meshCentroid /= meshArea;
+	std::vector<float> keys(clusters.size() - 1);
+	for (size_t c = 0; c < keys.size(); ++c) {
+	  float length = glm::length(normals[c]);
+	  keys[c] = length > 0 ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0;
+	}
+	std::vector<size_t> order(keys.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint> result;
+	result.reserve(indices.size());
+	for (auto c : order) {
+	  result.insert(result.end(), indices.begin() + (long)clusters[c] * 3, indices.begin() + (long)clusters[c + 1] * 3);
+	}
+	return result;
+  }
+
+  /**
+   * @brief renumbers vertices in order they are first used, so vertex fetch reads attribute buffers sequentially
+   * @details indices are rewritten in place
+   * @return new vertex for every old one, vertices no triangle uses get ~0u and are dropped by remapAttribute()
+   */
+  static std::vector<uint> optimizeVertexFetch(std::vector<uint> &indices, size_t vertexCount) {
+	std::vector<uint> remap(vertexCount, ~0u);
+	uint next = 0;
+	for (auto &index : indices) {
+	  if (remap[index] == ~0u) remap[index] = next++;
+	  index = remap[index];
+	}
+	return remap;
+  }
+
+  /**
+   * @brief moves attribute of every vertex to its new place from optimizeVertexFetch()
+   * @param components floats per vertex
+   */
+  static void remapAttribute(std::vector<float> &attribute, const std::vector<uint> &remap, int components) {
+	if (attribute.empty()) return;
+	size_t count = std::count_if(remap.begin(), remap.end(), [](uint vertex) { return vertex != ~0u; });
+	std::vector<float> result(count * components);
+	for (size_t i = 0; i < remap.size(); ++i) {
+	  if (remap[i] == ~0u) continue;
+	  std::copy_n(attribute.begin() + (long)i * components, components, result.begin() + (long)remap[i] * components);
+	}
+	attribute = std::move(result);
+  }
+
+ private:
+  static long skipDeadEnd(std::vector<unsigned int> &deadEnds, const std::vector<unsigned int> &live, size_t &cursor) {
+	while (!deadEnds.empty()) {
+	  auto vertex = deadEnds.back();
+	  deadEnds.pop_back();
+	  if (live[vertex] > 0) return vertex;
+	}
+	for (; cursor < live.size(); ++cursor) {
+	  if (live[cursor] > 0) return (long)cursor;
+	}
+	return -1;
+  }
+};
+
+#endif//CGCOURSEWORK_MESH_OPTIMIZER_HPP
@@ -0,0 +1,277 @@
+#ifndef CGCOURSEWORK_MESH_SIMPLIFIER_HPP
+#define CGCOURSEWORK_MESH_SIMPLIFIER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "functions.hpp"
+
+/**
+ * @brief quadric error edge collapse (Garland, Heckbert 1997) on indexed triangle lists
+ * @details vertices are collapsed onto their neighbours instead of new positions, so simplified index list
+ * still points into the original vertex arrays and levels of detail need nothing but their own index buffers.
+ * Vertices at one position (attribute seams, flat shading) are welded into a group that collapses as a whole:
+ * every copy moves onto the copy of the target it shares a triangle with, so seams slide along themselves and
+ * texture mapping stays intact. Copy that shares none (third face of a flat shaded box corner) takes the target
+ * copy with the closest normal. Groups on open borders only collapse along the border, weighted by planes
+ * standing on border edges, which keeps outlines of open meshes like the street lamp tube in place.
+ */
+class MeshSimplifier {
+ public:
+  /**
+   * @param positions 3 floats per vertex
+   * @param targetIndexCount simplification stops when index list is this short
+   * @param maxError simplification stops before any collapse would move surface further than this, in object units
+   * @param resultError set to error of the simplified mesh, in object units
+   * @param normals 3 floats per vertex, optional, picks target copy for corners of flat shaded faces
+   * @return simplified indices into the same vertices, never longer than source
+   */
+  static std::vector<uint> simplify(const std::vector<uint> &indices, const std::vector<float> &positions, size_t targetIndexCount,
+									float maxError, float *resultError = nullptr, const std::vector<float> *normals = nullptr) {
+	size_t vertexCount = positions.size() / 3;
+	if (normals != nullptr && normals->size() < positions.size()) normals = nullptr;
+	auto position = [&positions](uint vertex) { return glm::dvec3(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]); };
+
+	// vertices at the same position share quadric and collapse together, group is named by its first vertex
+	std::vector<uint> weld(vertexCount);
+	std::vector<unsigned int> copyOffsets(vertexCount + 1, 0), copies(vertexCount);
+	{
+	  std::unordered_map<std::string, uint> first;
+	  for (uint i = 0; i < vertexCount; ++i) {
+		weld[i] = first.emplace(std::string((const char *)&positions[i * 3], sizeof(float) * 3), i).first->second;
+		copyOffsets[weld[i] + 1]++;
+	  }
+	  for (size_t i = 0; i < vertexCount; ++i) copyOffsets[i + 1] += copyOffsets[i];
+	  std::vector<unsigned int> filled(copyOffsets.begin(), copyOffsets.end() - 1);
+	  for (uint i = 0; i < vertexCount; ++i) copies[filled[weld[i]]++] = i;
+	}
+	// edge used by one triangle only is a border, groups on it only slide along border edges and a plane standing
+	// on every border edge is added to their quadrics, so outline keeps its place; edges of more triangles lock their groups
+	auto edgeKey = [](uint a, uint b) { return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a; };
+	std::unordered_map<uint64_t, int> edges;
+	countEdges(indices, weld, edges);
+	std::vector<bool> border(vertexCount, false), locked(vertexCount, false);// by group
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+	  glm::dvec3 a = position(indices[i]), b = position(indices[i + 1]), c = position(indices[i + 2]);
+	  glm::dvec3 normal = glm::cross(b - a, c - a);
+	  double length = glm::length(normal);
+	  if (length > 0) normal /= length;
+	  for (int corner = 0; corner < 3 && length > 0; ++corner) {
+		quadrics[weld[indices[i + corner]]].add(glm::dvec4(normal, -glm::dot(normal, a)), length / 2);
+	  }
+	  for (int e = 0; e < 3; ++e) {
+		uint from = weld[indices[i + e]], to = weld[indices[i + (e + 1) % 3]];
+		int uses = edges[edgeKey(from, to)];
+		if (uses > 2) locked[from] = locked[to] = true;
+		if (uses != 1) continue;
+		border[from] = border[to] = true;
+		glm::dvec3 side = glm::cross(position(to) - position(from), normal);
+		double sideLength = glm::length(side);
+		if (sideLength <= 0) continue;
+		side /= sideLength;
+		// weighted like a square on the edge, so it matters as much as the faces next to it
+		double edgeLength = glm::length(position(to) - position(from));
+		glm::dvec4 borderPlane(side, -glm::dot(side, position(from)));
+		quadrics[from].add(borderPlane, edgeLength * edgeLength);
+		quadrics[to].add(borderPlane, edgeLength * edgeLength);
+	  }
+	}
+
+	std::vector<uint> result(indices.begin(), indices.end() - (long)(indices.size() % 3));
+	double maxCost = (double)maxError * maxError, error = 0;
+	std::vector<unsigned int> offsets(vertexCount + 1), adjacency;
+	std::vector<uint> collapse(vertexCount);
+	std::vector<bool> touched(vertexCount);// by group
+	std::vector<Collapse> candidates, moves;
+	while (result.size() > targetIndexCount) {
+	  buildAdjacency(result, vertexCount, offsets, adjacency);
+	  countEdges(result, weld, edges);
+	  candidates.clear();
+	  for (size_t i = 0; i < result.size(); i += 3) {
+		for (int e = 0; e < 3; ++e) {
+		  uint a = weld[result[i + e]], b = weld[result[i + (e + 1) % 3]];
+		  if (a == b) continue;
+		  bool alongBorder = edges[edgeKey(a, b)] == 1;
+		  if (!locked[a] && (!border[a] || alongBorder)) candidates.push_back({a, b, cost(quadrics[a], quadrics[b], position(b))});
+		  if (!locked[b] && (!border[b] || alongBorder)) candidates.push_back({b, a, cost(quadrics[a], quadrics[b], position(a))});
+		}
+	  }
+	  std::sort(candidates.begin(), candidates.end(), [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+	  // every collapse removes about two triangles, vertices around a collapse are not touched again in the same pass
+	  size_t goal = (result.size() - targetIndexCount) / 6 + 1, collapses = 0;
+	  for (uint i = 0; i < vertexCount; ++i) collapse[i] = i;
+	  std::fill(touched.begin(), touched.end(), false);
+	  for (auto &candidate : candidates) {
+		if (candidate.cost > maxCost || collapses >= goal) break;
+		if (touched[candidate.from] || touched[candidate.to]) continue;
+		if (!findMoves(result, offsets, adjacency, weld, copies, copyOffsets, normals, candidate, moves)) continue;
+		if (std::any_of(moves.begin(), moves.end(), [&](const Collapse &move) { return flips(result, offsets, adjacency, move, position); })) {
+		  continue;
+		}
+		for (auto &move : moves) {
+		  collapse[move.from] = move.to;
+		  for (auto t = offsets[move.from]; t < offsets[move.from + 1]; ++t) {
+			for (int corner = 0; corner < 3; ++corner) touched[weld[result[adjacency[t] * 3 + corner]]] = true;
+		  }
+		}
+		quadrics[candidate.to] += quadrics[candidate.from];
+		error = std::max(error, candidate.cost);
+		collapses++;
+	  }
+	  if (collapses == 0) break;
+
+	  size_t kept = 0;
+	  for (size_t i = 0; i < result.size(); i += 3) {
+		uint a = collapse[result[i]], b = collapse[result[i + 1]], c = collapse[result[i + 2]];
+		if (weld[a] == weld[b] || weld[b] == weld[c] || weld[a] == weld[c]) continue;
+		result[kept++] = a, result[kept++] = b, result[kept++] = c;
+	  }
+	  result.resize(kept);
+	}
+	if (resultError != nullptr) *resultError = (float)std::sqrt(error);
+	return result;
+  }
+
+ private:
+  struct Collapse {
+	uint from, to;
+	double cost;
+  };
+
+  /**
+   * @brief pairs every used copy of group collapse.from with the copy of group collapse.to it shares a triangle with,
+   * or with the copy whose normal is closest when it shares none
+   * @return false when no copy shares a triangle with the target, or when no triangle would be left around the group,
+   * which is how thin parts (bench planks) would disappear while hardly moving any plane
+   */
+  static bool findMoves(const std::vector<uint> &indices, const std::vector<unsigned int> &offsets, const std::vector<unsigned int> &adjacency,
+						const std::vector<uint> &weld, const std::vector<unsigned int> &copies, const std::vector<unsigned int> &copyOffsets,
+						const std::vector<float> *normals, const Collapse &collapse, std::vector<Collapse> &moves) {
+	moves.clear();
+	bool adjacent = false, survives = false;
+	for (auto c = copyOffsets[collapse.from]; c < copyOffsets[collapse.from + 1]; ++c) {
+	  uint from = copies[c], to = from;
+	  if (offsets[from] == offsets[from + 1]) continue;// not used any more
+	  for (auto t = offsets[from]; t < offsets[from + 1]; ++t) {
+		bool collapses = false;
+		for (int corner = 0; corner < 3; ++corner) {
+		  if (weld[indices[adjacency[t] * 3 + corner]] != collapse.to) continue;
+		  to = indices[adjacency[t] * 3 + corner];
+		  collapses = true;
+		}
+		survives = survives || !collapses;
+	  }
+	  adjacent = adjacent || to != from;
+	  if (to == from) to = closestCopy(from, collapse.to, copies, copyOffsets, offsets, normals);
+	  moves.push_back({from, to, collapse.cost});
+	}
+	return adjacent && survives;
+  }
+
+  /**
+   * @return used copy of group whose normal is the closest to normal of vertex, first used copy without normals
+   */
+  static uint closestCopy(uint vertex, uint group, const std::vector<unsigned int> &copies, const std::vector<unsigned int> &copyOffsets,
+						  const std::vector<unsigned int> &offsets, const std::vector<float> *normals) {
+	auto normal = [normals](uint i) { return glm::dvec3((*normals)[i * 3], (*normals)[i * 3 + 1], (*normals)[i * 3 + 2]); };
+	uint best = group;
+	double bestSimilarity = -INFINITY;
+	for (auto c = copyOffsets[group]; c < copyOffsets[group + 1]; ++c) {
+	  uint copy = copies[c];
+	  if (offsets[copy] == offsets[copy + 1]) continue;
+	  double similarity = normals != nullptr ? glm::dot(normal(vertex), normal(copy)) : 0;
+	  if (similarity > bestSimilarity) {
+		best = copy;
+		bestSimilarity = similarity;
+	  }
+	}
+	return best;
+  }
+
+  /**
+   * @brief planes around a group, weighted by area of faces they come from
+   */
+  struct Quadric {
+	glm::dmat4 planes{0};
+	double weight{0};
+
+	void add(const glm::dvec4 &plane, double planeWeight) {
+	  planes += glm::outerProduct(plane, plane) * planeWeight;
+	  weight += planeWeight;
+	}
+	Quadric &operator+=(const Quadric &other) {
+	  planes += other.planes;
+	  weight += other.weight;
+	  return *this;
+	}
+  };
+
+  /**
+   * @return mean squared distance of position from planes of both groups, sum would grow with every merged group
+   */
+  static double cost(const Quadric &a, const Quadric &b, const glm::dvec3 &position) {
+	double weight = a.weight + b.weight;
+	if (weight <= 0) return 0;
+	glm::dvec4 point(position, 1);
+	return std::max(0.0, glm::dot(point, (a.planes + b.planes) * point) / weight);
+  }
+
+  /**
+   * @brief how many triangles use every edge between groups
+   */
+  static void countEdges(const std::vector<uint> &indices, const std::vector<uint> &weld, std::unordered_map<uint64_t, int> &edges) {
+	edges.clear();
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+	  for (int e = 0; e < 3; ++e) {
+		uint a = weld[indices[i + e]], b = weld[indices[i + (e + 1) % 3]];
+		edges[a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a]++;
+	  }
+	}
+  }
+
+  /**
+   * @brief triangles around every vertex, as offsets into one array
+   */
+  static void buildAdjacency(const std::vector<uint> &indices, size_t vertexCount, std::vector<unsigned int> &offsets,
+							 std::vector<unsigned int> &adjacency) {
+	std::fill(offsets.begin(), offsets.end(), 0);
+	for (auto index : indices) offsets[index + 1]++;
+	for (size_t i = 0; i < vertexCount; ++i) offsets[i + 1] += offsets[i];
+	std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+	adjacency.resize(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i) adjacency[filled[indices[i]]++] = (unsigned int)(i / 3);
+  }
+
+  /**
+   * @brief checks that no triangle around collapsed vertex turns over or degenerates into a sliver
+   */
+  template<typename Position>
+  static bool flips(const std::vector<uint> &indices, const std::vector<unsigned int> &offsets, const std::vector<unsigned int> &adjacency,
+					const Collapse &collapse, const Position &position) {
+	for (auto t = offsets[collapse.from]; t < offsets[collapse.from + 1]; ++t) {
+	  const uint *triangle = &indices[adjacency[t] * 3];
+	  glm::dvec3 before[3], after[3], target = position(collapse.to);
+	  bool disappears = false;// triangles along collapsed edge
+	  for (int corner = 0; corner < 3; ++corner) {
+		before[corner] = position(triangle[corner]);
+		after[corner] = triangle[corner] == collapse.from ? target : before[corner];
+		disappears = disappears || before[corner] == target;
+	  }
+	  if (disappears) continue;
+	  glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+	  glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+	  double lengths = glm::length(normalBefore) * glm::length(normalAfter);
+	  if (lengths <= 0 || glm::dot(normalBefore, normalAfter) < 0.25 * lengths) return true;
+	}
+	return false;
+  }
+};
+
+#endif//CGCOURSEWORK_MESH_SIMPLIFIER_HPP
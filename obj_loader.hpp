@@ -1,22 +1,41 @@
+#ifndef CGLABS__OBJ_LOADER_HPP_
+#define CGLABS__OBJ_LOADER_HPP_
+
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
 #include <assimp/Importer.hpp>
 
+#include "cpu_profiler.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "startup_timer.hpp"
 #include "texture.hpp"
+#include "texture_cache.hpp"
 
 class ObjLoader {
  public:
+  /// assimp post processing every model is imported with
+  static constexpr unsigned int importFlags =
+	  aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType;
+
   struct MaterialInfo {
 	std::string name;
 	glm::vec3 ambient{};
 	glm::vec3 diffuse{};
 	glm::vec3 specular{};
 	float shininess{};
-	std::vector<Texture *> textures;
+	TextureCache::References textures;
+	std::vector<std::string> texturePaths;///< paths textures were acquired with, in the same order
+  };
+  /// simplified index list into the same vertices
+  struct LevelOfDetail {
+	std::vector<uint> indices;
+	float error{0};///< how far simplified surface may be from the original, in object units
   };
   struct loadedOBJ {
 	std::vector<uint> indices;
+	std::vector<LevelOfDetail> lods;///< coarser and coarser, full detail is indices
 	std::vector<float> vertices;
 	std::vector<float> texCoords;
 	std::vector<float> normals;
@@ -25,6 +44,7 @@ class ObjLoader {
 
  private:
   static std::vector<loadedOBJ> doTheSceneProcessing(const aiScene *scene) {
+	CPU_PROFILE_ZONE("ObjLoader::doTheSceneProcessing");
 	std::vector<loadedOBJ> loadedMeshes;
 	std::vector<MaterialInfo> materials;
 
@@ -39,66 +59,154 @@ class ObjLoader {
 	for (int i = 0; i < scene->mNumMeshes; ++i) {
 	  LOG_S(INFO) << "Mesh(" << i << ")";
 	  auto mesh = scene->mMeshes[i];
-	  uint num_faces = mesh->mNumFaces;
-
-	  std::vector<uint> indices;
-	  std::vector<float> vertices;
-	  std::vector<float> texCoords;
-	  std::vector<float> normals;
-	  // trying to extract indices
-	  for (int j = 0; j < num_faces; ++j) {
-		auto face = mesh->mFaces[j];
-		for (int k = 0; k < face.mNumIndices; ++k) {
-		  auto uv = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][face.mIndices[k]] : aiVector3D(0.0f, 0.0f, 0.0f);
-		  texCoords.push_back(uv.x);
-		  texCoords.push_back(uv.y);
-
-		  auto vertex = mesh->mVertices[face.mIndices[k]];
-
-		  vertices.push_back(vertex.x);
-		  vertices.push_back(vertex.y);
-		  vertices.push_back(vertex.z);
-		  if (mesh->HasNormals()) {
-			auto normal = mesh->mNormals[face.mIndices[k]];
-
-			normals.push_back(normal.x);
-			normals.push_back(normal.y);
-			normals.push_back(normal.z);
-		  }
-		}
-	  }
+	  auto loaded = indexMesh(mesh);
+	  optimizeMesh(loaded);
+	  buildLods(loaded);
+	  loaded.material = materials[mesh->mMaterialIndex];
 
-	  LOG_S(INFO) << "vertices: " << vertices.size();
-	  LOG_S(INFO) << "texCoords: " << texCoords.size();
-	  //LOG_S(INFO) << "indices: " << indices.size();
-	  LOG_S(INFO) << "normals: " << normals.size();
-	  LOG_S(INFO) << "material: " << materials[mesh->mMaterialIndex].name;
+	  LOG_S(INFO) << "vertices: " << loaded.vertices.size();
+	  LOG_S(INFO) << "texCoords: " << loaded.texCoords.size();
+	  LOG_S(INFO) << "indices: " << loaded.indices.size();
+	  for (auto &lod : loaded.lods) LOG_S(INFO) << "lod: " << lod.indices.size() << " indices, error " << lod.error;
+	  LOG_S(INFO) << "normals: " << loaded.normals.size();
+	  LOG_S(INFO) << "material: " << loaded.material.name;
 
 	  LOG_S(INFO) << "---------------";
-	  loadedMeshes.push_back({indices, vertices, texCoords, normals, materials[mesh->mMaterialIndex]});
+	  loadedMeshes.push_back(loaded);
 	}
 
 	return loadedMeshes;
   }
 
+ public:
+  /**
+   * @brief copies position, uv and normal of every face corner into flat arrays (material is not set)
+   * @param mesh mesh imported by assimp
+   * @return loadedOBJ without indices
+   */
+  static loadedOBJ flattenMesh(const aiMesh *mesh) {
+	loadedOBJ loaded;
+	uint num_faces = mesh->mNumFaces;
+	// trying to extract indices
+	for (int j = 0; j < num_faces; ++j) {
+	  auto face = mesh->mFaces[j];
+	  for (int k = 0; k < face.mNumIndices; ++k) {
+		auto uv = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][face.mIndices[k]] : aiVector3D(0.0f, 0.0f, 0.0f);
+		loaded.texCoords.push_back(uv.x);
+		loaded.texCoords.push_back(uv.y);
+
+		auto vertex = mesh->mVertices[face.mIndices[k]];
+
+		loaded.vertices.push_back(vertex.x);
+		loaded.vertices.push_back(vertex.y);
+		loaded.vertices.push_back(vertex.z);
+		if (mesh->HasNormals()) {
+		  auto normal = mesh->mNormals[face.mIndices[k]];
+
+		  loaded.normals.push_back(normal.x);
+		  loaded.normals.push_back(normal.y);
+		  loaded.normals.push_back(normal.z);
+		}
+	  }
+	}
+	return loaded;
+  }
+
+  /**
+   * @brief copies vertices shared by faces once and faces as indices into them (material is not set)
+   * @details JoinIdenticalVertices already merged equal corners, so vertices are reused by neighbouring faces
+   * @param mesh triangulated mesh imported by assimp
+   */
+  static loadedOBJ indexMesh(const aiMesh *mesh) {
+	loadedOBJ loaded;
+	loaded.vertices.reserve(mesh->mNumVertices * 3);
+	loaded.texCoords.reserve(mesh->mNumVertices * 2);
+	for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+	  auto &vertex = mesh->mVertices[i];
+	  loaded.vertices.insert(loaded.vertices.end(), {vertex.x, vertex.y, vertex.z});
+	  auto uv = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][i] : aiVector3D(0.0f, 0.0f, 0.0f);
+	  loaded.texCoords.insert(loaded.texCoords.end(), {uv.x, uv.y});
+	  if (mesh->HasNormals()) {
+		auto &normal = mesh->mNormals[i];
+		loaded.normals.insert(loaded.normals.end(), {normal.x, normal.y, normal.z});
+	  }
+	}
+	loaded.indices.reserve(mesh->mNumFaces * 3);
+	for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+	  auto &face = mesh->mFaces[i];
+	  loaded.indices.insert(loaded.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+	}
+	return loaded;
+  }
+
+  /**
+   * @brief reorders triangles for vertex cache and overdraw, then vertices for fetch, logs ACMR/ATVR before and after
+   */
+  static void optimizeMesh(loadedOBJ &loaded) {
+	CPU_PROFILE_ZONE("ObjLoader::optimizeMesh");
+	size_t vertexCount = loaded.vertices.size() / 3;
+	auto before = MeshOptimizer::analyzeVertexCache(loaded.indices, vertexCount);
+	auto cacheOrder = MeshOptimizer::optimizeVertexCache(loaded.indices, vertexCount);
+	// small meshes often come from assimp in better order than greedy fanning finds
+	if (MeshOptimizer::analyzeVertexCache(cacheOrder, vertexCount).acmr < before.acmr) loaded.indices = std::move(cacheOrder);
+	loaded.indices = MeshOptimizer::optimizeOverdraw(loaded.indices, loaded.vertices);
+	auto remap = MeshOptimizer::optimizeVertexFetch(loaded.indices, vertexCount);
+	MeshOptimizer::remapAttribute(loaded.vertices, remap, 3);
+	MeshOptimizer::remapAttribute(loaded.texCoords, remap, 2);
+	MeshOptimizer::remapAttribute(loaded.normals, remap, 3);
+	auto after = MeshOptimizer::analyzeVertexCache(loaded.indices, loaded.vertices.size() / 3);
+	LOG_S(INFO) << "ACMR: " << before.acmr << " -> " << after.acmr << ", ATVR: " << before.atvr << " -> " << after.atvr;
+  }
+
+  /**
+   * @brief simplifies mesh to half, quarter, eighth and sixteenth of its triangles, levels that barely simplify are skipped
+   */
+  static void buildLods(loadedOBJ &loaded) {
+	CPU_PROFILE_ZONE("ObjLoader::buildLods");
+	loaded.lods.clear();
+	glm::vec3 min{INFINITY}, max{-INFINITY};
+	for (size_t i = 0; i + 2 < loaded.vertices.size(); i += 3) {
+	  glm::vec3 vertex{loaded.vertices[i], loaded.vertices[i + 1], loaded.vertices[i + 2]};
+	  min = glm::min(min, vertex);
+	  max = glm::max(max, vertex);
+	}
+	float maxError = glm::length(max - min) * 0.125f;// a quarter of bounding sphere radius, coarser is never worth it
+	size_t previous = loaded.indices.size();
+	for (int level = 1; level <= 4; ++level) {
+	  size_t target = loaded.indices.size() / 3 >> level;
+	  LevelOfDetail lod;
+	  lod.indices = MeshSimplifier::simplify(loaded.indices, loaded.vertices, target * 3, maxError, &lod.error, &loaded.normals);
+	  if ((float)lod.indices.size() > (float)previous * 0.8f) break;
+	  lod.indices = MeshOptimizer::optimizeVertexCache(lod.indices, loaded.vertices.size() / 3);
+	  previous = lod.indices.size();
+	  loaded.lods.push_back(std::move(lod));
+	}
+  }
+
+ private:
+
   // C++ importer interface
   // Output data structure
   // Post processing flags
-  std::vector<loadedOBJ> doTheImportThing(const std::string &pFile) {
-	// Create an instance of the Importer class
-	Assimp::Importer importer;
+  std::vector<loadedOBJ> doTheImportThing(const std::string &pFile, Assimp::Importer &importer) {
 	// And have it read the given file with some example postprocessing
 	// Usually - if speed is not the most important aspect for you - you'll
 	// probably to request more postprocessing than we do in this example.
-	const aiScene *scene = importer.ReadFile(pFile,
-											 aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
+	const aiScene *scene;
+	{
+	  StartupTimer::Scope timer(pFile, StartupTimer::IMPORT);
+	  scene = importer.ReadFile(pFile, importFlags);
+	}
 	// If the import failed, report it
 	if (!scene) {
 	  LOG_S(FATAL) << "Failed to load file: " << importer.GetErrorString();
 	  return {};
 	}
 	// Now we can access the file's contents.
-	return doTheSceneProcessing(scene);
+	StartupTimer::Scope timer(pFile, StartupTimer::PROCESS);
+	auto meshes = doTheSceneProcessing(scene);
+	importer.FreeScene();
+	return meshes;
   }
 
   static MaterialInfo processMaterial(aiMaterial *material) {
@@ -117,14 +225,14 @@ class ObjLoader {
 	  material->GetTexture(aiTextureType_DIFFUSE, i, &str);
 	  std::string texName = "textures/";
 	  texName += str.C_Str();
-	  mat.textures.push_back(new Texture(texName));
+	  mat.texturePaths.push_back(texName);
 	}
 	for (unsigned int i = 0; i < material->GetTextureCount(aiTextureType_SPECULAR); i++) {
 	  aiString str;
 	  material->GetTexture(aiTextureType_SPECULAR, i, &str);
 	  std::string texName = "textures/";
 	  texName += str.C_Str();
-	  mat.textures.push_back(new Texture(texName));
+	  mat.texturePaths.push_back(texName);
 	}
 	if (shadingModel != aiShadingMode_Phong && shadingModel != aiShadingMode_Gouraud) {
 	  LOG_S(WARNING)
@@ -154,6 +262,29 @@ class ObjLoader {
 
  public:
   std::vector<loadedOBJ> loadObj(const std::string &filename) {
-	return doTheImportThing(filename);
+	Assimp::Importer importer;
+	auto meshes = doTheImportThing(filename, importer);
+	acquireTextures(meshes);
+	return meshes;
+  }
+
+  /**
+   * @brief imports without touching GL, so it can run on any thread, textures are only listed in MaterialInfo::texturePaths
+   * @param importer reused between calls of one thread, importer can't be used by two threads at once
+   */
+  std::vector<loadedOBJ> loadObj(const std::string &filename, Assimp::Importer &importer) {
+	return doTheImportThing(filename, importer);
   }
-};
\ No newline at end of file
+
+  /**
+   * @brief fills MaterialInfo::textures from texturePaths through TextureCache, needs GL context
+   */
+  static void acquireTextures(std::vector<loadedOBJ> &meshes) {
+	for (auto &mesh : meshes) {
+	  mesh.material.textures.clear();
+	  for (auto &path : mesh.material.texturePaths) mesh.material.textures.push_back(TextureCache::acquire(path));
+	}
+  }
+};
+
+#endif //CGLABS__OBJ_LOADER_HPP_
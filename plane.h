@@ -7,12 +7,14 @@
 
 #include <glm/gtx/normal.hpp>
 
+#include "cpu_profiler.hpp"
 #include "functions.hpp"
 #include "renderer.hpp"
+#include "texture_cache.hpp"
 
 class Plane {
   std::vector<Buffer> buffers{};
-  std::vector<Texture *> textures{};
+  TextureCache::References textures{};
   VertexArray *vao{nullptr};
   glm::mat4 model{};
   glm::vec3 position{0, 0, 0};
@@ -104,6 +106,7 @@ class Plane {
   }
 
   Plane *draw(Shader *shader) {
+	CPU_PROFILE_ZONE("Plane::draw");
 	if (!textures.empty()) {
 	  for (int i = 0; i < textures.size(); ++i) {
 		textures[i]->bind(i);
@@ -127,7 +130,7 @@ class Plane {
   }
 
   Plane *addTexture(const std::string &filePath) {
-	textures.push_back(new Texture(filePath));
+	textures.push_back(TextureCache::acquire(filePath));
 	if (!wasBufferDefined(Buffer::TEXTURE_COORDS)) {
 	  LOG_S(INFO) << "Generating textureCoords";
 	  if (texCoordsIgnoreScale) {
@@ -158,6 +161,7 @@ class Plane {
 
  private:
   Plane *addNewBuffer(Buffer _buffer, bool bReplace = false) {
+	GpuMemory::setOwner(GpuMemory::BUFFER, _buffer.rendererID, "planes");
 	bool wasReplaced = false;
 	for (auto &buffer : buffers) {
 	  if (_buffer.bufferType == buffer.bufferType && buffer.bufferType != Buffer::OTHER) {
@@ -248,11 +252,11 @@ class Plane {
 	return this;
   }
 
-  std::vector<Texture *> getTextures() {
+  TextureCache::References getTextures() {
 	return textures;
   }
 
-  Plane *setTextures(std::vector<Texture *> _textures) {
+  Plane *setTextures(TextureCache::References _textures) {
 	textures = std::move(_textures);
     if (!wasBufferDefined(Buffer::TEXTURE_COORDS)) {
       LOG_S(INFO) << "Generating textureCoords";
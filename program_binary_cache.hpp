@@ -0,0 +1,149 @@
+#ifndef CGCOURSEWORK_PROGRAM_BINARY_CACHE_HPP
+#define CGCOURSEWORK_PROGRAM_BINARY_CACHE_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "functions.hpp"
+
+/**
+ * @brief keeps linked GL programs on disk with glGetProgramBinary(), so later launches skip compiling and linking
+ * @details file name is a hash of shader sources and GL vendor, renderer and version strings, the file repeats
+ * the whole key and stores binary format next to the binary. Binary that driver does not accept any more
+ * (new driver, other format) is deleted and program is built from source again.
+ */
+class ProgramBinaryCache {
+  struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t binaryFormat;
+	uint64_t keyHash;
+	uint64_t keySize;
+	uint64_t binarySize;///< key follows header, binary follows key
+  };
+  static constexpr char magic[8]{'V', 'L', 'P', 'R', 'O', 'G', 0, 0};
+  static constexpr uint32_t version = 1;///< bump when layout changes
+
+ public:
+  /**
+   * @brief directory cache files are written to, relative to working directory
+   */
+  static std::string &directory() {
+	static std::string path{"cache/programs"};
+	return path;
+  }
+  static bool &enabled() {
+	static bool value{true};
+	return value;
+  }
+
+  /**
+   * @brief whether context can save and load program binaries at all
+   */
+  static bool isSupported() {
+	if (!enabled() || !GLAD_GL_VERSION_4_1) return false;
+	GLint formats{0};
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+  }
+
+  /**
+   * @brief everything program binary depends on, sources and the driver that compiled them
+   */
+  static std::string keyFor(const std::string &vertexShader, const std::string &fragmentShader) {
+	std::string key;
+	for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+	  auto *value = (const char *)glGetString(name);
+	  key += value != nullptr ? value : "";
+	  key += '\n';
+	}
+	key += vertexShader;
+	key += '\0';
+	key += fragmentShader;
+	return key;
+  }
+
+  /**
+   * @return linked program made from cached binary, 0 when there is none or driver rejected it
+   */
+  static unsigned int load(const std::string &key) {
+	if (!isSupported()) return 0;
+	std::string path = pathFor(key);
+	auto file = readBinaryFile(path);
+	if (file.empty()) return 0;
+	Header header{};
+	if (file.size() < sizeof(Header)) return reject(path, "is truncated");
+	std::memcpy(&header, file.data(), sizeof(Header));
+	if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) return reject(path, "has other layout");
+	if (header.keySize != key.size() || header.keyHash != hashBytes(key.data(), key.size()) || sizeof(Header) + header.keySize + header.binarySize != file.size() ||
+		std::memcmp(file.data() + sizeof(Header), key.data(), key.size()) != 0) {
+	  return reject(path, "belongs to other sources or driver");
+	}
+	if (!isFormatSupported(header.binaryFormat)) return reject(path, "has binary format driver does not support");
+
+	unsigned int program = glCreateProgram();
+	glCall(glProgramBinary(program, header.binaryFormat, file.data() + sizeof(Header) + header.keySize, (GLsizei)header.binarySize));
+	int linked;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE) {
+	  glCall(glDeleteProgram(program));
+	  return reject(path, "was rejected by driver");
+	}
+	return program;
+  }
+
+  /**
+   * @brief saves binary of linked program, program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+   */
+  static void store(unsigned int program, const std::string &key) {
+	if (!isSupported()) return;
+	GLint length{0};
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+	std::vector<char> binary((size_t)length);
+	GLenum binaryFormat;
+	glCall(glGetProgramBinary(program, length, &length, &binaryFormat, binary.data()));
+	Header header{};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.binaryFormat = binaryFormat;
+	header.keyHash = hashBytes(key.data(), key.size());
+	header.keySize = key.size();
+	header.binarySize = (uint64_t)length;
+
+	std::vector<unsigned char> file(sizeof(header) + key.size() + (size_t)length);
+	std::memcpy(file.data(), &header, sizeof(header));
+	std::memcpy(file.data() + sizeof(header), key.data(), key.size());
+	std::memcpy(file.data() + sizeof(header) + key.size(), binary.data(), (size_t)length);
+	std::string path = pathFor(key);
+	if (!writeFileAtomically(path, file)) LOG_S(WARNING) << "Unable to write program binary " << path;
+  }
+
+ private:
+  static std::string pathFor(const std::string &key) {
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << hashBytes(key.data(), key.size()) << ".vlprog";
+	return (std::filesystem::path(directory()) / name.str()).string();
+  }
+
+  static bool isFormatSupported(GLenum binaryFormat) {
+	GLint count{0};
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+	std::vector<GLint> formats((size_t)count);
+	if (count > 0) glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+	return std::find(formats.begin(), formats.end(), (GLint)binaryFormat) != formats.end();
+  }
+
+  static unsigned int reject(const std::string &path, const std::string &reason) {
+	LOG_S(INFO) << "Program binary " << path << " " << reason << ", building from source";
+	std::error_code error;
+	std::filesystem::remove(path, error);
+	return 0;
+  }
+};
+
+#endif//CGCOURSEWORK_PROGRAM_BINARY_CACHE_HPP
@@ -0,0 +1,92 @@
+#ifndef CGCOURSEWORK_RENDER_STATS_HPP
+#define CGCOURSEWORK_RENDER_STATS_HPP
+
+#include <sstream>
+
+#include "frame_time_stats.hpp"
+#include "functions.hpp"
+#include "gpu_memory.hpp"
+
+/**
+ * @brief per-frame counters of draw calls and state changes
+ * @details Renderer, Shader, Texture and VertexArray increment current() counters,
+ * Renderer::newFrame() moves them to lastFrame() and records frame time
+ */
+class RenderStats {
+ public:
+  struct Counters {
+	long drawCalls{0};
+	long vertices{0};       ///< vertices submitted by non-indexed draws
+	long indices{0};        ///< indices submitted by indexed draws
+	long shaderBinds{0};    ///< Shader::bind() calls
+	long programSwitches{0};///< binds that actually changed current program
+	long textureBinds{0};
+	long vertexArrayBinds{0};
+	long uniformCalls{0};
+  };
+  static constexpr size_t frameHistorySize = 600;
+
+  static Counters &current() {
+	static Counters counters;
+	return counters;
+  }
+  static Counters &lastFrame() {
+	static Counters counters;
+	return counters;
+  }
+  /**
+   * @brief frame times of last frameHistorySize frames
+   */
+  static FrameTimeStats &frameTimes() {
+	static FrameTimeStats stats(frameHistorySize);
+	return stats;
+  }
+
+  /**
+   * @brief finishes current frame: records its time and counters, resets counters
+   */
+  static void newFrame() {
+	static double frameStart = -1;
+	double now = glfwGetTime();
+	if (frameStart >= 0) {
+	  frameTimes().add((now - frameStart) * 1000.0);
+	  lastFrame() = current();
+	}
+	frameStart = now;
+	current() = {};
+  }
+
+  static void onProgramBind(unsigned int program) {
+	current().shaderBinds++;
+	if (program != boundProgram()) {
+	  current().programSwitches++;
+	  boundProgram() = program;
+	}
+  }
+
+  /**
+   * @brief one line summary of last frame counters and recent frame times
+   */
+  static std::string summary() {
+	auto &counters = lastFrame();
+	auto times = frameTimes().summarize();
+	std::ostringstream ss;
+	ss.precision(3);
+	ss << "fps: " << (times.avg > 0 ? 1000.0 / times.avg : 0.0)
+	   << " | frame ms avg " << times.avg << " p50 " << times.p50 << " p95 " << times.p95 << " p99 " << times.p99
+	   << " | draws " << counters.drawCalls << " verts " << counters.vertices << " idx " << counters.indices
+	   << " | programs " << counters.programSwitches << "/" << counters.shaderBinds
+	   << " textures " << counters.textureBinds << " vaos " << counters.vertexArrayBinds
+	   << " uniforms " << counters.uniformCalls
+	   << " | " << GpuMemory::summary();
+	return ss.str();
+  }
+
+ private:
+  static unsigned int &boundProgram() {
+	static unsigned int program{0};
+	return program;
+  }
+};
+
+#endif//CGCOURSEWORK_RENDER_STATS_HPP
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "Buffers/vertex_array.hpp"
+#include "render_stats.hpp"
 #include "shader.hpp"
 
 class Renderer {
@@ -53,12 +54,35 @@ static void draw(VertexArray *vertexArray, IndexBuffer *indexBuffer, Shader *sha
 	vao->bind();
 	shader->bind();
 	glCall(glDrawArrays(mode, 0, range));
+	RenderStats::current().drawCalls++;
+	RenderStats::current().vertices += (long)range;
   }
   static void draw(IndexBuffer *ibo,VertexArray*vao, Shader *shader,unsigned long range, GLuint mode = GL_TRIANGLES) {
 	vao->bind();
 	ibo->bind();
 	shader->bind();
-	glCall(glDrawElements(mode,range, GL_UNSIGNED_INT, nullptr));
+	glCall(glDrawElements(mode,range, ibo->getType(), nullptr));
+	RenderStats::current().drawCalls++;
+	RenderStats::current().indices += (long)range;
+  }
+  /**
+   * @brief starts new frame for render statistics
+   * @details call once per frame before drawing, counters of finished frame are available through getLastFrameStats()
+   */
+  static void newFrame() {
+	RenderStats::newFrame();
+  }
+  /**
+   * @brief counters of last finished frame
+   */
+  static const RenderStats::Counters &getLastFrameStats() {
+	return RenderStats::lastFrame();
+  }
+  /**
+   * @brief frame times of recent frames, use summarize() to get percentiles
+   */
+  static const FrameTimeStats &getFrameTimes() {
+	return RenderStats::frameTimes();
   }
 };
 
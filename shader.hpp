@@ -5,12 +5,19 @@
 #ifndef CGLABS__SHADER_HPP_
 #define CGLABS__SHADER_HPP_
 
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 
+#include "cpu_profiler.hpp"
 #include "functions.hpp"
+#include "program_binary_cache.hpp"
+#include "render_stats.hpp"
+#include "startup_timer.hpp"
 
 class Shader {
 
@@ -22,7 +29,7 @@ class Shader {
     std::string fragmentShader{};///< @brief program for fragment shader
   };
 #if not defined(__WIN32__)
-  std::chrono::time_point<std::filesystem::_FilesystemClock> lastWriteToFile;
+  std::filesystem::file_time_type lastWriteToFile;
 #endif
   bool bLiveReload = false;
 
@@ -44,18 +51,77 @@ class Shader {
     bind();
 
   }
+  struct Deferred {};
+  using Defines = std::vector<std::pair<std::string, std::string>>;///< name and value of every #define added to both stages
+  /**
+   * @brief submits program to driver without waiting for it, fallback() draws in its place until it is built
+   * @details submit every program first and check them later, so driver compiles them in parallel
+   * (GL_KHR_parallel_shader_compile) or at least while CPU is busy with something else.
+   * Uniforms set in the meantime are remembered and set on the program when it is ready.
+   */
+  Shader(const std::string &_filepath, Deferred, bool bEnableLiveReload = false) : Shader(_filepath, {}, Deferred{}, bEnableLiveReload) {
+  }
+  /**
+   * @brief deferred shader specialized with defines, see ShaderPermutations
+   */
+  Shader(const std::string &_filepath, Defines _defines, Deferred, bool bEnableLiveReload = false) : defines(std::move(_defines)) {
+#if not defined(__WIN32__)
+    lastWriteToFile = std::filesystem::last_write_time(_filepath);
+#endif
+    if (bEnableLiveReload) enableLiveReload();
+    filepath = _filepath;
+    source = parseShader();
+    submitShader();
+    LOG_S(INFO) << "Submitted shader with id: " << rendererID;
+  }
   ~Shader() {
+    if (pending) {
+      glCall(glDeleteShader(pendingShaders[0]));
+      glCall(glDeleteShader(pendingShaders[1]));
+    }
     glCall(glDeleteProgram(rendererID));
     LOG_S(INFO) << "destroyed shader with id: " << rendererID;
   }
   /**
-   * @brief Activates shader.
+   * @brief program drawn instead of deferred programs that are not built yet, without it bind() waits for them
+   */
+  static Shader *&fallback() {
+    static Shader *shader{nullptr};
+    return shader;
+  }
+  /**
+   * @brief Activates shader, or fallback() while it is still being built.
    */
-  [[maybe_unused]] void bind() const {
+  [[maybe_unused]] void bind() {
+    if (pending && (fallback() == nullptr || isBuilt())) finishShader();
+    if (pending) {
+      fallback()->bind();
+      return;
+    }
     glCall(glUseProgram(rendererID));
+    RenderStats::onProgramBind(rendererID);
+  }
+  /**
+   * @return false while deferred program is being built, never waits when driver has GL_KHR_parallel_shader_compile
+   */
+  [[nodiscard]] bool isReady() {
+    return !pending || isBuilt();
+  }
+  /**
+   * @brief waits until deferred program is built
+   */
+  void finish() {
+    if (pending) finishShader();
+  }
+  /**
+   * @return false if deferred program failed to link, known only after it is built (see finish())
+   */
+  [[nodiscard]] bool isLinked() const {
+    return linked;
   }
   [[maybe_unused]] static void unbind() {
     glCall(glUseProgram(0));
+    RenderStats::onProgramBind(0);
   }
   /**
    * @brief Sets uniform of 1 value with type int in shader
@@ -63,11 +129,11 @@ class Shader {
    * @param value value to set uniform to
    */
   [[maybe_unused]] void setUniform1i(const std::string &name, GLint value) {
-    glCall(glUniform1i(getUniformLocation(name), value));
+    setUniform(name, [value](GLint location) { glCall(glUniform1i(location, value)); });
   }
 
   [[maybe_unused]] void setUniform1f(const std::string &name, GLfloat value) {
-    glCall(glUniform1f(getUniformLocation(name), value));
+    setUniform(name, [value](GLint location) { glCall(glUniform1f(location, value)); });
   }
   /**
    * @brief Sets uniform with vec4
@@ -75,13 +141,13 @@ class Shader {
    * @param value value to set uniform to
    */
   [[maybe_unused]] void setUniform4f(const std::string &name, glm::vec4 vec4) {
-    glCall(glUniform4f(getUniformLocation(name), vec4.x, vec4.y, vec4.z, vec4.w));
+    setUniform(name, [vec4](GLint location) { glCall(glUniform4f(location, vec4.x, vec4.y, vec4.z, vec4.w)); });
   }
   [[maybe_unused]] void setUniform3f(const std::string &name, glm::vec3 vec3) {
-    glCall(glUniform3f(getUniformLocation(name), vec3.x, vec3.y, vec3.z));
+    setUniform(name, [vec3](GLint location) { glCall(glUniform3f(location, vec3.x, vec3.y, vec3.z)); });
   }
   [[maybe_unused]] void setUniform2f(const std::string &name, glm::vec2 vec2) {
-    glCall(glUniform2f(getUniformLocation(name), vec2.x, vec2.y));
+    setUniform(name, [vec2](GLint location) { glCall(glUniform2f(location, vec2.x, vec2.y)); });
   }
   /**
   * @brief Sets uniform with mat4
@@ -89,12 +155,13 @@ class Shader {
   * @param value value to set uniform to
   */
   [[maybe_unused]] void setUniformMat4f(const std::string &name, const glm::mat4 &matrix) {
-    glCall(glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+    setUniform(name, [matrix](GLint location) { glCall(glUniformMatrix4fv(location, 1, GL_FALSE, &matrix[0][0])); });
   }
 
   [[maybe_unused]] void reload() {
 #if not defined(__WIN32__)
     if (isReloadRequired()) {
+		finish();
 		lastWriteToFile = std::filesystem::last_write_time(filepath);
 		source = parseShader();
 		rendererID = createShader(true);
@@ -107,6 +174,13 @@ class Shader {
     bLiveReload = true;
   }
 
+  /**
+   * @return whether program was specialized with this define, see ShaderPermutations
+   */
+  [[nodiscard]] bool isDefined(const std::string &name) const {
+    return std::any_of(defines.begin(), defines.end(), [&name](const auto &define) { return define.first == name; });
+  }
+
   bool doesUniformExist(const std::string &name) {
     if (getUniformLocation(name, true) == -1) {
       return false;
@@ -117,7 +191,24 @@ class Shader {
 
  private:
   ShaderProgramSource source;
+  Defines defines;
   std::unordered_map<std::string, int> uniformLocationCache;///< cache of uniforms locations
+  bool pending{false};                ///< deferred program is not built yet, fallback() is bound instead
+  unsigned int pendingShaders[2]{0, 0};///< vertex and fragment shader of pending program
+  std::string cacheKey;               ///< ProgramBinaryCache key of pending program
+  bool linked{true};                  ///< deferred program linked, set when it is built
+  std::unordered_map<std::string, std::function<void(GLint)>> pendingUniforms;///< last value of every uniform set while pending
+
+  /**
+   * @brief sets uniform of this program, or of fallback() while pending, remembering value for this program
+   * @param setter calls glUniform* with given location
+   */
+  template<typename Setter>
+  void setUniform(const std::string &name, Setter setter) {
+    if (pending) pendingUniforms[name] = setter;
+    setter(getUniformLocation(name));
+    RenderStats::current().uniformCalls++;
+  }
 
   /**
    * @brief gets location of uniform in shader
@@ -125,6 +216,8 @@ class Shader {
    * @returns location of uniform if successful else -1
    */
   [[nodiscard]] GLint getUniformLocation(const std::string &name, bool allowedToFail = false) {
+    CPU_PROFILE_ZONE("Shader::getUniformLocation");
+    if (pending && fallback() != nullptr) return fallback()->getUniformLocation(name, true);
     if (uniformLocationCache.find(name) != uniformLocationCache.end()) {
       return uniformLocationCache[name];
     }
@@ -141,15 +234,21 @@ class Shader {
 
   /**
    * @brief Parses file that contains the shader
+   * @details #include "file" lines are replaced with that file (path is relative to including file),
+   * defines are added right after #version line of both stages
    * @returns source code for vertex and fragment shader.
    */
   ShaderProgramSource parseShader() {
+    StartupTimer::Scope timer(filepath, StartupTimer::READ);
     LOG_S(INFO) << "Parsing shader at: " << filepath.c_str();
-    std::ifstream stream(filepath);
-    if (stream.fail()) {
+    std::ifstream file(filepath);
+    if (file.fail()) {
       LOG_S(FATAL) << "Unable to open shader file at: " << filepath.c_str();
       throw std::runtime_error("Unable to open shader file");
     }
+    file.close();
+    std::vector<std::string> includeStack;
+    std::stringstream stream(expandIncludes(filepath, includeStack));
     std::string line;
     std::stringstream ss[2];
     enum class shaderType {
@@ -165,14 +264,75 @@ class Shader {
         } else if (line.find("fragment") != std::string::npos) {
           type = shaderType::FRAGMENT;
         }
-      } else {
+      } else if (type != shaderType::NONE) {
         ss[(int)type] << line << "\n";
+        if (line.find("#version") != std::string::npos) {
+          for (auto &[name, value] : defines) ss[(int)type] << "#define " << name << " " << value << "\n";
+        }
       }
     }
     LOG_S(INFO) << "Shader parsed successfully";
     return {ss[0].str(), ss[1].str()};
   }
 
+  /**
+   * @return text of file with every #include "file" line replaced by that file, recursively
+   * @details directive has to start the line (after whitespace) outside of block comments, like preprocessor expects,
+   * so commented out includes stay comments
+   * @param includeStack files being expanded, including one of them again is reported and skipped
+   */
+  static std::string expandIncludes(const std::string &path, std::vector<std::string> &includeStack) {
+    if (std::find(includeStack.begin(), includeStack.end(), path) != includeStack.end()) {
+      LOG_S(ERROR) << "Shader file " << path << " includes itself";
+      return "";
+    }
+    std::ifstream stream(path);
+    if (stream.fail()) {
+      LOG_S(ERROR) << "Unable to open shader include at: " << path << (includeStack.empty() ? "" : " included from " + includeStack.back());
+      return "";
+    }
+    includeStack.push_back(path);
+    std::string line, result;
+    bool inBlockComment = false;
+    while (std::getline(stream, line)) {
+      bool startsInComment = inBlockComment;
+      inBlockComment = endsInBlockComment(line, inBlockComment);
+      auto hash = line.find_first_not_of(" \t");
+      auto directive = hash == std::string::npos || line[hash] != '#' ? std::string::npos : line.find_first_not_of(" \t", hash + 1);
+      bool isInclude = !startsInComment && directive != std::string::npos && line.compare(directive, 7, "include") == 0;
+      auto open = isInclude ? line.find('"', directive) : std::string::npos;
+      auto close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+      if (close != std::string::npos) {
+        auto included = std::filesystem::path(path).parent_path() / line.substr(open + 1, close - open - 1);
+        result += expandIncludes(included.lexically_normal().string(), includeStack);
+      } else {
+        result += line + "\n";
+      }
+    }
+    includeStack.pop_back();
+    return result;
+  }
+
+  /**
+   * @return whether block comment is still open at the end of line, line comments are skipped
+   */
+  static bool endsInBlockComment(const std::string &line, bool inBlockComment) {
+    for (size_t i = 0; i + 1 < line.size(); ++i) {
+      if (inBlockComment) {
+        if (line[i] == '*' && line[i + 1] == '/') {
+          inBlockComment = false;
+          ++i;
+        }
+      } else if (line[i] == '/' && line[i + 1] == '/') {
+        break;
+      } else if (line[i] == '/' && line[i + 1] == '*') {
+        inBlockComment = true;
+        ++i;
+      }
+    }
+    return inBlockComment;
+  }
+
   /**
    * @brief Compiles shader program
    * @param type fragment or vertex
@@ -215,24 +375,144 @@ class Shader {
   }
 
   /**
- * @brief Creates shader that can be used
+ * @brief Creates shader that can be used, from ProgramBinaryCache when sources were linked before
  * @return reference to final shader program
  */
   unsigned int createShader(bool isReload = false) {
+    std::string cacheKey = ProgramBinaryCache::keyFor(source.vertexShader, source.fragmentShader);
+    {
+      StartupTimer::Scope timer(filepath, StartupTimer::LINK);
+      unsigned int cached = ProgramBinaryCache::load(cacheKey);
+      if (cached != 0) {
+        LOG_S(INFO) << "Loaded program binary of " << filepath;
+        return cached;
+      }
+    }
     unsigned int program = glCreateProgram();
-    unsigned int vShader = compileShader(GL_VERTEX_SHADER, source.vertexShader, isReload);
-    unsigned int fShader = compileShader(GL_FRAGMENT_SHADER, source.fragmentShader, isReload);
+    unsigned int vShader, fShader;
+    {
+      StartupTimer::Scope timer(filepath, StartupTimer::COMPILE);
+      vShader = compileShader(GL_VERTEX_SHADER, source.vertexShader, isReload);
+      fShader = compileShader(GL_FRAGMENT_SHADER, source.fragmentShader, isReload);
+    }
     if ((vShader == 0 || fShader == 0) && isReload) return rendererID;
     glCall(glAttachShader(program, vShader));
     glCall(glAttachShader(program, fShader));
-    glCall(glLinkProgram(program));
-    glCall(glValidateProgram(program));
+    if (ProgramBinaryCache::isSupported()) glCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    {
+      StartupTimer::Scope timer(filepath, StartupTimer::LINK);
+      glCall(glLinkProgram(program));
+      int linked;
+      glGetProgramiv(program, GL_LINK_STATUS, &linked);// waits for link to finish so it is timed here
+      if (linked == GL_FALSE) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        LOG_S(ERROR) << "Failed to link shader " << filepath << ": " << log;
+      }
+      glCall(glValidateProgram(program));
+      if (linked != GL_FALSE) ProgramBinaryCache::store(program, cacheKey);
+    }
 
     glCall(glDeleteShader(vShader));
     glCall(glDeleteShader(fShader));
     return program;
   }
 
+  /**
+   * @brief compiles and links without asking for any status, so nothing waits for the driver here
+   */
+  void submitShader() {
+    cacheKey = ProgramBinaryCache::keyFor(source.vertexShader, source.fragmentShader);
+    {
+      StartupTimer::Scope timer(filepath, StartupTimer::LINK);
+      rendererID = ProgramBinaryCache::load(cacheKey);
+      if (rendererID != 0) {
+        LOG_S(INFO) << "Loaded program binary of " << filepath;
+        return;
+      }
+    }
+    StartupTimer::Scope timer(filepath, StartupTimer::COMPILE);
+    if (hasParallelCompile()) LOG_S(INFO) << "Compiling " << filepath << " in parallel";
+    rendererID = glCreateProgram();
+    GLenum types[2]{GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    const char *sources[2]{source.vertexShader.c_str(), source.fragmentShader.c_str()};
+    for (int i = 0; i < 2; ++i) {
+      pendingShaders[i] = glCreateShader(types[i]);
+      glCall(glShaderSource(pendingShaders[i], 1, &sources[i], nullptr));
+      glCall(glCompileShader(pendingShaders[i]));
+      glCall(glAttachShader(rendererID, pendingShaders[i]));
+    }
+    if (ProgramBinaryCache::isSupported()) glCall(glProgramParameteri(rendererID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    glCall(glLinkProgram(rendererID));
+    pending = true;
+  }
+
+  /**
+   * @brief waits for pending program, reports its errors and sets uniforms that were set while it was pending
+   */
+  void finishShader() {
+    StartupTimer::Scope timer(filepath, StartupTimer::LINK);
+    pending = false;
+    for (auto shader : pendingShaders) {
+      int compiled;
+      glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+      if (compiled == GL_FALSE) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        LOG_S(FATAL) << "Failed to compile shader " << filepath << ": " << log;
+      }
+      glCall(glDeleteShader(shader));
+    }
+    int linkStatus;
+    glGetProgramiv(rendererID, GL_LINK_STATUS, &linkStatus);
+    linked = linkStatus != GL_FALSE;
+    if (!linked) {
+      char log[1024];
+      glGetProgramInfoLog(rendererID, sizeof(log), nullptr, log);
+      LOG_S(ERROR) << "Failed to link shader " << filepath << ": " << log;
+    } else {
+      ProgramBinaryCache::store(rendererID, cacheKey);
+    }
+    glCall(glValidateProgram(rendererID));
+    glCall(glUseProgram(rendererID));
+    for (auto &[name, setter] : pendingUniforms) setter(getUniformLocation(name, true));
+    pendingUniforms.clear();
+    RenderStats::onProgramBind(rendererID);
+    LOG_S(INFO) << "Shader " << filepath << " is ready, id: " << rendererID;
+  }
+
+  /**
+   * @return whether pending program is built, always true without GL_KHR_parallel_shader_compile,
+   * then status is asked for (and waited for) on first bind(), so the build is synchronous and only overlaps
+   * whatever happens between construction and the first bind
+   */
+  bool isBuilt() const {
+    if (!hasParallelCompile()) return true;
+    GLint complete{GL_FALSE};
+    glGetProgramiv(rendererID, completionStatus, &complete);
+    return complete == GL_TRUE;
+  }
+
+  static constexpr GLenum completionStatus = 0x91B1;///< GL_COMPLETION_STATUS_KHR, generated GL loader has no extensions
+
+  /**
+   * @brief whether driver builds programs on its own threads, lets it use as many as it wants when it does
+   */
+  static bool hasParallelCompile() {
+    static bool supported = [] {
+      using MaxShaderCompilerThreads = void (*)(GLuint);
+      for (auto extension : {"KHR", "ARB"}) {
+        if (!glfwExtensionSupported((std::string("GL_") + extension + "_parallel_shader_compile").c_str())) continue;
+        auto maxThreads = (MaxShaderCompilerThreads)glfwGetProcAddress((std::string("glMaxShaderCompilerThreads") + extension).c_str());
+        if (maxThreads != nullptr) maxThreads(0xFFFFFFFF);
+        LOG_S(INFO) << "GL_" << extension << "_parallel_shader_compile is supported";
+        return true;
+      }
+      return false;
+    }();
+    return supported;
+  }
+
   [[maybe_unused]] void disableLiveReload() {
     bLiveReload = false;
   }
@@ -0,0 +1,86 @@
+#ifndef CGCOURSEWORK_SHADER_PERMUTATIONS_HPP
+#define CGCOURSEWORK_SHADER_PERMUTATIONS_HPP
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "shader.hpp"
+
+/**
+ * @brief variants of one shader file specialized with defines, each built on first use and kept
+ * @details specialized variant has no branch on useTexture, no specular term when there is no specular map
+ * and constant light loop bounds the compiler can unroll. Shader file decides what to do with each define
+ * and falls back to uniforms when one is not defined (see lighting_shader.glsl).
+ * Variants are built deferred, so Shader::fallback() draws until they are ready.
+ * Renderer drawing with lighting_shader.glsl picks variant of each mesh with
+ * get(mesh->permutationKey(lightsManager.permutationKey())). Main still draws with simple_shader.glsl,
+ * golden image test builds every variant the scene needs and fails when one doesn't link.
+ */
+class ShaderPermutations {
+ public:
+  struct Key {
+	bool textured{true};///< TEXTURED, diffuse and specular come from textures instead of material colors
+	bool specular{true};///< HAS_SPECULAR, 0 drops specular term
+	int dirLights{0};   ///< NUM_DIR_LIGHTS
+	int pointLights{0}; ///< NUM_POINT_LIGHTS
+	int spotLights{0};  ///< NUM_SPOT_LIGHTS
+
+	[[nodiscard]] Shader::Defines defines() const {
+	  return {{"TEXTURED", std::to_string((int)textured)},
+			  {"HAS_SPECULAR", std::to_string((int)specular)},
+			  {"NUM_DIR_LIGHTS", std::to_string(dirLights)},
+			  {"NUM_POINT_LIGHTS", std::to_string(pointLights)},
+			  {"NUM_SPOT_LIGHTS", std::to_string(spotLights)}};
+	}
+	[[nodiscard]] std::string name() const {
+	  std::string result;
+	  for (auto &[define, value] : defines()) result += (result.empty() ? "" : " ") + define + "=" + value;
+	  return result;
+	}
+	bool operator<(const Key &other) const {
+	  return std::tie(textured, specular, dirLights, pointLights, spotLights) <
+			 std::tie(other.textured, other.specular, other.dirLights, other.pointLights, other.spotLights);
+	}
+  };
+
+  explicit ShaderPermutations(std::string _filepath) : filepath(std::move(_filepath)) {}
+
+  /**
+   * @return variant for key, submitted to driver on first request
+   */
+  Shader *get(const Key &key) {
+	auto &variant = variants[key];
+	if (variant == nullptr) {
+	  LOG_S(INFO) << "Building " << filepath << " variant " << key.name();
+	  variant = std::make_unique<Shader>(filepath, key.defines(), Shader::Deferred{});
+	}
+	return variant.get();
+  }
+
+  /**
+   * @brief waits until every variant requested so far is built
+   * @return false if any of them failed to link
+   */
+  bool finish() {
+	bool linked = true;
+	for (auto &[key, variant] : variants) {
+	  variant->finish();
+	  if (!variant->isLinked()) {
+		LOG_S(ERROR) << filepath << " variant " << key.name() << " failed to link";
+		linked = false;
+	  }
+	}
+	return linked;
+  }
+
+  [[nodiscard]] size_t size() const {
+	return variants.size();
+  }
+
+ private:
+  std::string filepath;
+  std::map<Key, std::unique_ptr<Shader>> variants;
+};
+
+#endif//CGCOURSEWORK_SHADER_PERMUTATIONS_HPP
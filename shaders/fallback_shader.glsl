@@ -0,0 +1,21 @@
+#shader vertex
+#version 410 core
+
+layout(location=0)in vec4 position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main(){
+    gl_Position = projection * view * model * position;
+}
+
+#shader fragment
+#version 410 core
+
+layout(location=0)out vec4 color;
+
+void main(){
+    color = vec4(0.5, 0.5, 0.5, 1.0);
+}
@@ -27,51 +27,7 @@ void main()
 
 out vec4 FragColor;
 
-struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
-
-    vec3 mat_diffuse;
-    vec3 mat_specular;
-    vec3 mat_ambient;
-
-    float shininess;
-};
-
-struct DirLight {
-    vec3 direction;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+#include "lights.glsl"
 
 #define NR_POINT_LIGHTS 30
 #define NR_DIR_LIGHTS 30
@@ -82,9 +38,20 @@ in vec3 Normal;
 in vec2 TexCoords;
 
 uniform vec3 viewPos;
+// ShaderPermutations defines light counts as constants, so loops below have constant bounds
+#ifndef NUM_POINT_LIGHTS
 uniform int NUM_POINT_LIGHTS;
+#endif
+#ifndef NUM_SPOT_LIGHTS
 uniform int NUM_SPOT_LIGHTS;
+#endif
+#ifndef NUM_DIR_LIGHTS
 uniform int NUM_DIR_LIGHTS;
+#endif
+// without permutation specular term is always computed
+#ifndef HAS_SPECULAR
+#define HAS_SPECULAR 1
+#endif
 uniform DirLight dirLights[NR_DIR_LIGHTS];
 uniform PointLight pointLights[NR_POINT_LIGHTS];
 uniform SpotLight spotLight[NR_SPOT_LIGHTS];
@@ -109,7 +76,7 @@ void main()
     // this fragment's final color.
     // == =====================================================
     // phase 1: directional lighting
-    vec3 result;
+    vec3 result = vec3(0.0);
     for (int i = 0; i < NUM_DIR_LIGHTS; i++)
     result += CalcDirLight(dirLights[i], norm, viewDir);
     // phase 2: point lights
@@ -134,16 +101,25 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     // combine results
     vec3 ambient;
     vec3 diffuse;
-    vec3 specular;
-    if (useTexture==1){
+    vec3 specular = vec3(0.0);
+#ifdef TEXTURED
+    bool textured = TEXTURED == 1;
+#else
+    bool textured = useTexture == 1;
+#endif
+    if (textured){
         ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
         diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+#if HAS_SPECULAR
         specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+#endif
     }
     else {
         ambient = light.ambient * material.mat_diffuse;
         diffuse = light.diffuse * diff *material. mat_diffuse;
+#if HAS_SPECULAR
         specular = light.specular * spec * material.mat_specular;
+#endif
     }
     return (ambient + diffuse + specular);
 }
@@ -163,7 +139,11 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+#if HAS_SPECULAR
     vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+#else
+    vec3 specular = vec3(0.0);
+#endif
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -189,7 +169,11 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+#if HAS_SPECULAR
     vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+#else
+    vec3 specular = vec3(0.0);
+#endif
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
@@ -0,0 +1,193 @@
+#ifndef CGCOURSEWORK_SIMULATION_HPP
+#define CGCOURSEWORK_SIMULATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "camera.hpp"
+#include "cpu_profiler.hpp"
+#include "frame_pacer.hpp"
+#include "mesh.hpp"
+
+/**
+ * @brief fixed timestep update of camera and object transforms, optionally on its own thread
+ * @details update works on a private back snapshot, after every step it is published as the newest front pair
+ * (previous and current step). Renderer copies the front pair, interpolates between its snapshots and only submits draws.
+ * Without a thread the same steps are advanced from the render loop.
+ */
+class Simulation {
+ public:
+  struct Transform {
+	glm::vec3 position{0, 0, 0};
+	glm::vec3 origin{0, 0, 0};
+	glm::vec3 rotation{0, 0, 0};///< degrees
+	glm::vec3 scale{1, 1, 1};
+
+	static Transform of(const Mesh &mesh) {
+	  return {mesh.position, mesh.origin, mesh.rotation, mesh.scale};
+	}
+	[[nodiscard]] glm::mat4 getModel() const {
+	  return Mesh::calculateModel(position, origin, rotation, scale);
+	}
+	/**
+	 * @brief interpolates transforms, rotation goes the shorter way around
+	 */
+	static Transform lerp(const Transform &a, const Transform &b, float t) {
+	  return {glm::mix(a.position, b.position, t), glm::mix(a.origin, b.origin, t),
+			  a.rotation + (glm::mod(b.rotation - a.rotation + 540.f, 360.f) - 180.f) * t, glm::mix(a.scale, b.scale, t)};
+	}
+  };
+  struct CameraPose {
+	glm::vec3 position{0, 0, 0};
+	float yaw{YAW};
+	float pitch{PITCH};
+	float zoom{ZOOM};
+
+	static CameraPose of(const Camera &camera) {
+	  return {camera.Position, camera.Yaw, camera.Pitch, camera.Zoom};
+	}
+	void applyTo(Camera *camera) const {
+	  camera->Position = position;
+	  camera->Zoom = zoom;
+	  camera->setOrientation(yaw, pitch);
+	}
+	static CameraPose lerp(const CameraPose &a, const CameraPose &b, float t) {
+	  return {glm::mix(a.position, b.position, t), a.yaw + (b.yaw - a.yaw) * t, a.pitch + (b.pitch - a.pitch) * t,
+			  a.zoom + (b.zoom - a.zoom) * t};
+	}
+  };
+  struct Snapshot {
+	long step{0};
+	double time{0};///< glfwGetTime() when this step was published
+	CameraPose camera;
+	std::vector<Transform> transforms;///< one per mesh, in order of meshes vector
+  };
+  /**
+   * @brief input collected by GLFW callbacks on main thread and consumed by update
+   */
+  struct Input {
+	std::atomic<int> pressedKey{-1};
+	std::mutex mutex;
+	glm::dvec2 mouseOffset{0, 0};
+	double scrollOffset{0};
+
+	void addMouseOffset(double x, double y) {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  mouseOffset += glm::dvec2(x, y);
+	}
+	void addScrollOffset(double offset) {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  scrollOffset += offset;
+	}
+	/**
+	 * @brief returns mouse and scroll offsets accumulated since last call
+	 */
+	std::pair<glm::dvec2, double> consume() {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  auto result = std::make_pair(mouseOffset, scrollOffset);
+	  mouseOffset = {0, 0};
+	  scrollOffset = 0;
+	  return result;
+	}
+  };
+  using Update = std::function<void(Snapshot &state, double step)>;
+
+ private:
+  Update update;
+  FixedTimestep timestep;
+  Snapshot back;                       ///< written only by update
+  Snapshot frontPrevious, frontCurrent;///< newest published pair, guarded by mutex
+  std::mutex mutex;
+  std::thread thread;
+  std::atomic<bool> running{false};
+
+ public:
+  /**
+   * @param initial state before first step
+   * @param stepsPerSecond simulation rate
+   * @param _update advances state by one step, called on simulation thread if it is started
+   */
+  Simulation(Snapshot initial, double stepsPerSecond, Update _update) : timestep(stepsPerSecond) {
+	update = std::move(_update);
+	back = std::move(initial);
+	back.time = glfwGetTime();
+	frontPrevious = back;
+	frontCurrent = back;
+  }
+  ~Simulation() {
+	stop();
+  }
+
+  /**
+   * @brief starts simulation thread, after that advance() must not be called
+   */
+  void start() {
+	running = true;
+	thread = std::thread([this] { threadLoop(); });
+	LOG_S(INFO) << "Simulation thread started, " << 1.0 / timestep.getStep() << " steps per second";
+  }
+  void stop() {
+	if (!running) return;
+	running = false;
+	thread.join();
+  }
+  [[nodiscard]] bool isThreaded() const {
+	return running;
+  }
+  [[nodiscard]] double getStep() const {
+	return timestep.getStep();
+  }
+
+  /**
+   * @brief advances simulation from render loop when there is no simulation thread
+   * @param frameTime seconds since previous call
+   */
+  void advance(double frameTime) {
+	timestep.advance(frameTime, [this](double step) { stepOnce(step); });
+  }
+
+  /**
+   * @brief copies newest published pair of snapshots
+   * @param previous, current filled with the pair
+   * @return interpolation factor between them for current time
+   */
+  float latest(Snapshot &previous, Snapshot &current) {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  previous = frontPrevious;
+	  current = frontCurrent;
+	}
+	if (!isThreaded()) return (float)timestep.alpha();
+	// rendering runs one step behind simulation, so there is always a newer snapshot to interpolate to
+	return (float)std::clamp((glfwGetTime() - current.time) / timestep.getStep(), 0.0, 1.0);
+  }
+
+ private:
+  void stepOnce(double step) {
+	CPU_PROFILE_ZONE("Simulation::step");
+	update(back, step);
+	back.step++;
+	back.time = glfwGetTime();
+	std::lock_guard<std::mutex> lock(mutex);
+	frontPrevious = std::move(frontCurrent);
+	frontCurrent = back;
+  }
+
+  void threadLoop() {
+	using clock = std::chrono::steady_clock;
+	auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timestep.getStep()));
+	auto next = clock::now();
+	while (running) {
+	  stepOnce(timestep.getStep());
+	  next += period;
+	  auto now = clock::now();
+	  if (now > next + period * 8) next = now;// too far behind, skip steps instead of simulating them in a burst
+	  std::this_thread::sleep_until(next);
+	}
+  }
+};
+
+#endif//CGCOURSEWORK_SIMULATION_HPP
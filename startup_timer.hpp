@@ -0,0 +1,164 @@
+#ifndef CGCOURSEWORK_STARTUP_TIMER_HPP
+#define CGCOURSEWORK_STARTUP_TIMER_HPP
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "cpu_profiler.hpp"
+#include "functions.hpp"
+
+/**
+ * @brief attributes loading time to assets and loading phases
+ * @details scopes can be nested (e.g. textures loaded while model is imported), every scope is charged
+ * only for its own time, time of nested scopes goes to their own asset and phase.
+ * Phases are also recorded as CpuProfiler zones when it is enabled.
+ */
+class StartupTimer {
+ public:
+  enum Phase {
+	READ,   ///< reading file to memory
+	DECODE, ///< image decoding
+	IMPORT, ///< assimp import with post processing
+	PROCESS,///< converting imported data to our layout
+	UPLOAD, ///< creating GL buffers and textures
+	MIPMAPS,///< glGenerateMipmap
+	COMPILE,///< shader compilation
+	LINK,   ///< program linking
+	PHASES_COUNT
+  };
+  struct AssetTimes {
+	std::string asset;
+	std::array<double, PHASES_COUNT> milliseconds{};
+	double total{0};
+  };
+
+  static const char *phaseName(Phase phase) {
+	static const char *names[PHASES_COUNT]{"read", "decode", "import", "process", "upload", "mipmaps", "compile", "link"};
+	return names[phase];
+  }
+
+  /**
+   * @brief RAII scope that charges its time to asset and phase
+   */
+  class Scope {
+	std::string asset;
+	Phase phase;
+	int64_t start;
+	int64_t nestedTime{0};
+	Scope *parent;
+
+   public:
+	Scope(std::string _asset, Phase _phase) : asset(std::move(_asset)), phase(_phase), start(CpuProfiler::now()), parent(current()) {
+	  current() = this;
+	}
+	~Scope() {
+	  int64_t duration = CpuProfiler::now() - start;
+	  current() = parent;
+	  if (parent != nullptr) parent->nestedTime += duration;
+	  record(asset, phase, (double)(duration - nestedTime) / 1e6);
+	  if (CpuProfiler::isEnabled()) CpuProfiler::record(phaseName(phase), start, duration);
+	}
+	Scope(const Scope &) = delete;
+	Scope &operator=(const Scope &) = delete;
+
+   private:
+	static Scope *&current() {
+	  thread_local Scope *scope{nullptr};
+	  return scope;
+	}
+  };
+
+  /**
+   * @brief adds time to asset and phase
+   */
+  static void record(const std::string &asset, Phase phase, double milliseconds) {
+	std::lock_guard<std::mutex> lock(mutex());
+	auto &times = assets()[asset];
+	times.asset = asset;
+	times.milliseconds[phase] += milliseconds;
+	times.total += milliseconds;
+  }
+
+  /**
+   * @brief every asset that was timed, slowest first
+   */
+  static std::vector<AssetTimes> sorted() {
+	std::lock_guard<std::mutex> lock(mutex());
+	std::vector<AssetTimes> result;
+	result.reserve(assets().size());
+	for (auto &[asset, times] : assets()) result.push_back(times);
+	std::sort(result.begin(), result.end(), [](const AssetTimes &a, const AssetTimes &b) { return a.total > b.total; });
+	return result;
+  }
+
+  /**
+   * @brief logs time of each phase and slowest assets
+   * @param timeToFirstFrame wall time from program start to first presented frame, in milliseconds
+   * @param maxAssets how many assets are logged
+   */
+  static void logReport(double timeToFirstFrame, size_t maxAssets = 15) {
+	auto assetTimes = sorted();
+	std::array<double, PHASES_COUNT> phaseTotals{};
+	double total = 0;
+	for (auto &times : assetTimes) {
+	  for (int phase = 0; phase < PHASES_COUNT; ++phase) phaseTotals[phase] += times.milliseconds[phase];
+	  total += times.total;
+	}
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(1);
+	ss << "Startup: " << timeToFirstFrame << " ms to first frame, " << total << " ms attributed to " << assetTimes.size() << " assets |";
+	for (int phase = 0; phase < PHASES_COUNT; ++phase) ss << " " << phaseName((Phase)phase) << " " << phaseTotals[phase];
+	LOG_S(INFO) << ss.str();
+	for (size_t i = 0; i < std::min(maxAssets, assetTimes.size()); ++i) {
+	  std::ostringstream line;
+	  line << std::fixed << std::setprecision(1) << std::setw(8) << assetTimes[i].total << " ms  " << assetTimes[i].asset << " (";
+	  bool first = true;
+	  for (int phase = 0; phase < PHASES_COUNT; ++phase) {
+		if (assetTimes[i].milliseconds[phase] <= 0) continue;
+		line << (first ? "" : ", ") << phaseName((Phase)phase) << " " << assetTimes[i].milliseconds[phase];
+		first = false;
+	  }
+	  line << ")";
+	  LOG_S(INFO) << line.str();
+	}
+  }
+
+  /**
+   * @brief writes every asset with time of every phase as CSV
+   * @return true on success
+   */
+  static bool writeCsv(const std::string &filepath) {
+	std::ofstream stream(filepath);
+	if (stream.fail()) {
+	  LOG_S(ERROR) << "Unable to write startup report to: " << filepath;
+	  return false;
+	}
+	stream << "asset,total_ms";
+	for (int phase = 0; phase < PHASES_COUNT; ++phase) stream << "," << phaseName((Phase)phase) << "_ms";
+	stream << "\n";
+	for (auto &times : sorted()) {
+	  stream << "\"" << times.asset << "\"," << times.total;
+	  for (double milliseconds : times.milliseconds) stream << "," << milliseconds;
+	  stream << "\n";
+	}
+	LOG_S(INFO) << "Startup report written to: " << filepath;
+	return true;
+  }
+
+ private:
+  static std::map<std::string, AssetTimes> &assets() {
+	static std::map<std::string, AssetTimes> map;
+	return map;
+  }
+  static std::mutex &mutex() {
+	static std::mutex m;
+	return m;
+  }
+};
+
+#endif//CGCOURSEWORK_STARTUP_TIMER_HPP
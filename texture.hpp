@@ -5,51 +5,200 @@
 #ifndef CGLABS__TEXTURE_HPP_
 #define CGLABS__TEXTURE_HPP_
 
+#include <iostream>
+#include <tuple>
 #include <utility>
+#include "cpu_profiler.hpp"
 #include "functions.hpp"
+#include "gpu_memory.hpp"
+#include "ktx_file.hpp"
+#include "render_stats.hpp"
+#include "startup_timer.hpp"
+
+/**
+ * @brief sampling parameters of a texture, part of TextureCache key
+ */
+struct TextureSampler {
+    GLint wrap{GL_REPEAT};
+    GLint minFilter{GL_LINEAR};
+    GLint magFilter{GL_LINEAR};
+
+    bool operator<(const TextureSampler &other) const {
+        return std::tie(wrap, minFilter, magFilter) < std::tie(other.wrap, other.minFilter, other.magFilter);
+    }
+};
 
 class Texture {
 private:
     unsigned int rendererID{};
     std::string filepath{};
     std::vector<unsigned char> localBuffer{};
-    int width, height, nrChannels;
+    int width{0}, height{0}, nrChannels{0};
+    bool ready{false};
 
 public:
-    explicit Texture(std::string _filepath) {
-	  filepath = _filepath;
+    /// tag of constructor that doesn't load the image
+    struct Deferred {};
+
+    /**
+     * @brief creates texture object without image, until upload() it is bound as placeholder
+     */
+    Texture(std::string _filepath, TextureSampler sampler, Deferred) {
+        filepath = std::move(_filepath);
         glGenTextures(1, &rendererID);
         glBindTexture(GL_TEXTURE_2D, rendererID);
 // set the texture wrapping/filtering options (on the currently bound texture object)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-// load and generate the texture
-        stbi_set_flip_vertically_on_load(1);
-        unsigned char *data = stbi_load(_filepath.c_str(), &width, &height, &nrChannels, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+        unbind();
+    }
+
+    /**
+     * @brief loads texture synchronously
+     */
+    explicit Texture(std::string _filepath, TextureSampler sampler = {}) : Texture(std::move(_filepath), sampler, Deferred{}) {
+        CPU_PROFILE_ZONE("Texture::Texture");
+        KtxFile cooked;
+        if (readCooked(filepath, cooked)) {
+            uploadCompressed(cooked, cooked.data.data());
+            return;
+        }
+        int imageWidth, imageHeight, channels;
+        unsigned char *data = decode(filepath, imageWidth, imageHeight, channels);
         if (data) {
+            upload(data, imageWidth, imageHeight, channels);
+        } else {
+            LOG_S(WARNING) << "Failed to load texture at "+filepath;
+        }
+        stbi_image_free(data);
+    }
+
+    /**
+     * @brief reads and decodes image, doesn't touch GL so it can be called from any thread
+     * @details RGB images stay RGB, everything else (grey, grey with alpha) is expanded to RGBA,
+     * so channels is always 3 or 4 and matches the format upload() passes to GL
+     * @return pixels that have to be freed with stbi_image_free(), nullptr on failure
+     */
+    static unsigned char *decode(const std::string &filepath, int &width, int &height, int &channels) {
+        stbi_set_flip_vertically_on_load_thread(1);
+        std::vector<unsigned char> file;
+        {
+            StartupTimer::Scope timer(filepath, StartupTimer::READ);
+            file = readBinaryFile(filepath);
+        }
+        if (file.empty()) return nullptr;
+        StartupTimer::Scope timer(filepath, StartupTimer::DECODE);
+        int sourceChannels{0};
+        if (!stbi_info_from_memory(file.data(), (int)file.size(), &width, &height, &sourceChannels)) return nullptr;
+        channels = sourceChannels == 3 ? 3 : 4;
+        return stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &sourceChannels, channels);
+    }
+
+    /**
+     * @brief whether textures are loaded from KTX files made by vlTextureCooker when they are available
+     * @details call it on GL thread, it checks which compressed formats the context supports
+     */
+    static void useCooked(bool enable) {
+        cookedEnabled() = enable;
+        if (enable) KtxFile::querySupportedFormats();
+    }
+
+    /**
+     * @brief reads cooked version of image if it is enabled, up to date and supported, can be called from any thread
+     * @return false if source image has to be decoded instead
+     */
+    static bool readCooked(const std::string &filepath, KtxFile &cooked) {
+        if (!cookedEnabled() || !KtxFile::isUpToDate(filepath)) return false;
+        std::string cookedPath = KtxFile::cookedPath(filepath);
+        std::string error;
+        {
+            StartupTimer::Scope timer(filepath, StartupTimer::READ);
+            error = cooked.parse(readBinaryFile(cookedPath));
+        }
+        if (error.empty() && !KtxFile::isSupported(cooked.internalFormat)) error = "format is not supported by driver";
+        if (!error.empty()) LOG_S(WARNING) << "Ignoring cooked texture " << cookedPath << ": " << error;
+        return error.empty();
+    }
+
+    /**
+     * @brief uploads every mip level of cooked texture, after that texture is ready
+     * @param data cooked.data or offset of its copy in currently bound GL_PIXEL_UNPACK_BUFFER
+     */
+    void uploadCompressed(const KtxFile &cooked, const unsigned char *data) {
+        width = cooked.width;
+        height = cooked.height;
+        nrChannels = cooked.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 3 : 4;
+        glBindTexture(GL_TEXTURE_2D, rendererID);
+        {
+            StartupTimer::Scope timer(filepath, StartupTimer::UPLOAD);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)cooked.levels.size() - 1);
+            for (size_t i = 0; i < cooked.levels.size(); ++i) {
+                auto &level = cooked.levels[i];
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, cooked.internalFormat, level.width, level.height, 0,
+                                       (GLsizei)level.size, (const void *)((uintptr_t)data + level.offset));
+            }
+        }
+        GpuMemory::track(GpuMemory::TEXTURE, rendererID, cooked.data.size(), filepath);
+        ready = true;
+        unbind();
+    }
+
+    /**
+     * @brief uploads image and generates mipmaps, after that texture is ready
+     * @param pixels image in memory or offset in currently bound GL_PIXEL_UNPACK_BUFFER
+     */
+    void upload(const void *pixels, int _width, int _height, int channels) {
+        width = _width;
+        height = _height;
+        nrChannels = channels;
+        glBindTexture(GL_TEXTURE_2D, rendererID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);// stb_image rows are tightly packed
+        {
+            StartupTimer::Scope timer(filepath, StartupTimer::UPLOAD);
             if (nrChannels == 3) {
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
             } else {
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
             }
+        }
+        {
+            StartupTimer::Scope timer(filepath, StartupTimer::MIPMAPS);
             glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            LOG_S(WARNING) << "Failed to load texture at "+filepath;
-			std::cout<<filepath<<std::endl;
         }
-        stbi_image_free(data);
+        // drivers store RGB8 as RGBA8, so both are counted as 4 bytes per pixel
+        GpuMemory::track(GpuMemory::TEXTURE, rendererID, GpuMemory::textureBytes(width, height, 4, true), filepath);
+        ready = true;
         unbind();
     }
 
+    static bool &cookedEnabled() {
+        static bool enabled{false};
+        return enabled;
+    }
+
+    /**
+     * @brief texture that is bound instead of textures whose image isn't uploaded yet, 0 if none
+     */
+    static GLuint &placeholder() {
+        static GLuint id{0};
+        return id;
+    }
+
+    [[nodiscard]] bool isReady() const {
+        return ready;
+    }
+
     ~Texture() {
         glCall(glDeleteTextures(1, &rendererID));
+        GpuMemory::release(GpuMemory::TEXTURE, rendererID);
     }
 
     void bind(unsigned int slot = 0) const {
         glCall(glActiveTexture(GL_TEXTURE0 + slot));
-        glCall(glBindTexture(GL_TEXTURE_2D, rendererID));
+        glCall(glBindTexture(GL_TEXTURE_2D, ready || placeholder() == 0 ? rendererID : placeholder()));
+        RenderStats::current().textureBinds++;
     }
 
     [[maybe_unused]] static void unbind() {
@@ -85,6 +234,10 @@ public:
     [[nodiscard]] GLuint getID() const {
         return rendererID;
     }
+
+    [[nodiscard]] const std::string &getFilepath() const {
+        return filepath;
+    }
 };
 
 #endif //CGLABS__TEXTURE_HPP_
\ No newline at end of file
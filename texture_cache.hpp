@@ -0,0 +1,155 @@
+#ifndef CGCOURSEWORK_TEXTURE_CACHE_HPP
+#define CGCOURSEWORK_TEXTURE_CACHE_HPP
+
+#include <filesystem>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "functions.hpp"
+#include "texture.hpp"
+#include "texture_loader.hpp"
+
+/**
+ * @brief reference counted textures keyed by canonical path and sampler settings
+ * @details every image is decoded and uploaded once, no matter through how many paths ("textures/a.png",
+ * "./textures/a.png") or from how many meshes it is requested. Texture is deleted when the last reference is released.
+ * Owners keep textures in References, which retains them when copied and releases them when destroyed.
+ * While TextureLoader is running new textures are loaded asynchronously.
+ */
+class TextureCache {
+  struct Entry {
+	Texture *texture{nullptr};
+	int references{0};
+  };
+  using Key = std::pair<std::string, TextureSampler>;
+
+  struct State {
+	std::map<Key, Entry> entries;
+	std::unordered_map<const Texture *, Key> keys;
+	unsigned long hits{0};
+  };
+  static State &state() {
+	static State s;
+	return s;
+  }
+
+ public:
+  /**
+   * @brief textures that hold one reference each, used like a std::vector of them
+   * @details copies retain every texture again, destruction and clear() release them, so meshes, planes
+   * and materials can be copied and dropped freely. Only push_back() textures that come from acquire().
+   */
+  class References : private std::vector<Texture *> {
+	using List = std::vector<Texture *>;
+
+   public:
+	References() = default;
+	References(const References &other) : List(other) {
+	  for (auto *texture : *this) retain(texture);
+	}
+	References(References &&other) noexcept : List(std::move(other)) {}
+	References &operator=(References other) noexcept {
+	  List::swap(other);
+	  return *this;
+	}
+	~References() {
+	  clear();
+	}
+
+	void clear() {
+	  for (auto *texture : *this) release(texture);
+	  List::clear();
+	}
+
+	using List::begin;
+	using List::empty;
+	using List::end;
+	using List::operator[];
+	using List::push_back;
+	using List::size;
+  };
+
+  /**
+   * @brief returns texture loaded from filepath, loading it only on first request
+   * @details every call adds a reference, pair it with release() when the texture is no longer used
+   */
+  static Texture *acquire(const std::string &filepath, TextureSampler sampler = {}) {
+	auto &s = state();
+	Key key{canonicalPath(filepath), sampler};
+	auto &entry = s.entries[key];
+	if (entry.texture == nullptr) {
+	  entry.texture = TextureLoader::isRunning() ? TextureLoader::load(filepath, sampler) : new Texture(filepath, sampler);
+	  s.keys[entry.texture] = key;
+	} else {
+	  s.hits++;
+	}
+	entry.references++;
+	return entry.texture;
+  }
+
+  /**
+   * @brief adds a reference to texture obtained from acquire()
+   */
+  static Texture *retain(Texture *texture) {
+	auto &s = state();
+	auto key = s.keys.find(texture);
+	if (key != s.keys.end()) s.entries[key->second].references++;
+	return texture;
+  }
+
+  /**
+   * @brief removes a reference, texture is deleted when none are left
+   */
+  static void release(Texture *texture) {
+	auto &s = state();
+	auto key = s.keys.find(texture);
+	if (key == s.keys.end()) {
+	  LOG_S(WARNING) << "Releasing texture that is not in cache";
+	  return;
+	}
+	auto entry = s.entries.find(key->second);
+	if (--entry->second.references > 0) return;
+	TextureLoader::cancel(entry->second.texture);
+	delete entry->second.texture;
+	s.entries.erase(entry);
+	s.keys.erase(key);
+  }
+
+  /**
+   * @brief deletes every cached texture regardless of references, call it before context is destroyed
+   */
+  static void clear() {
+	auto &s = state();
+	for (auto &[key, entry] : s.entries) {
+	  TextureLoader::cancel(entry.texture);
+	  delete entry.texture;
+	}
+	s.entries.clear();
+	s.keys.clear();
+  }
+
+  [[nodiscard]] static size_t size() {
+	return state().entries.size();
+  }
+
+  /**
+   * @brief how many acquire() calls were served without loading
+   */
+  [[nodiscard]] static unsigned long getHits() {
+	return state().hits;
+  }
+
+  static std::string summary() {
+	return "Texture cache: " + std::to_string(size()) + " textures, " + std::to_string(getHits()) + " loads avoided";
+  }
+
+ private:
+  static std::string canonicalPath(const std::string &filepath) {
+	std::error_code error;
+	auto path = std::filesystem::weakly_canonical(filepath, error);
+	return error ? std::filesystem::path(filepath).lexically_normal().string() : path.string();
+  }
+};
+
+#endif//CGCOURSEWORK_TEXTURE_CACHE_HPP
@@ -0,0 +1,240 @@
+#ifndef CGCOURSEWORK_TEXTURE_LOADER_HPP
+#define CGCOURSEWORK_TEXTURE_LOADER_HPP
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "cpu_profiler.hpp"
+#include "functions.hpp"
+#include "texture.hpp"
+
+/**
+ * @brief decodes textures on worker threads and uploads them from GL thread through a pixel buffer object
+ * @details load() returns immediately with a texture that is bound as placeholder until poll() uploads its image.
+ * Workers only read and decode files (cooked KTX files are only read), every GL call happens on the thread that calls poll().
+ */
+class TextureLoader {
+  struct Job {
+	Texture *texture;
+	uint64_t id;
+  };
+  struct Decoded {
+	Texture *texture;
+	uint64_t id;
+	unsigned char *pixels;
+	int width, height, channels;
+	std::shared_ptr<KtxFile> cooked;///< set instead of pixels when cooked texture was read
+  };
+  struct State {
+	std::mutex mutex;
+	std::condition_variable jobAdded, jobDecoded;
+	std::deque<Job> jobs;
+	std::deque<Decoded> decoded;
+	std::unordered_map<const Texture *, uint64_t> pending;///< textures that are not uploaded yet, with id of their job
+	uint64_t nextId{1};
+	std::vector<std::thread> workers;
+	bool running{false};
+	GLuint pixelBuffer{0};
+  };
+  static State &state() {
+	static State s;
+	return s;
+  }
+
+ public:
+  /**
+   * @brief starts worker threads, needs GL context
+   * @param placeholder loaded texture that is bound instead of textures that are still loading
+   * @param threads amount of workers, 0 to use all cores but one
+   */
+  static void start(const Texture *placeholder, unsigned int threads = 0) {
+	auto &s = state();
+	if (s.running) return;
+	if (threads == 0) {
+	  // hardware_concurrency() may be 0 when it is unknown, subtracting from it would wrap around
+	  unsigned int cores = std::thread::hardware_concurrency();
+	  threads = cores > 1 ? cores - 1 : 1;
+	}
+	Texture::placeholder() = placeholder->getID();
+	glGenBuffers(1, &s.pixelBuffer);
+	s.running = true;
+	for (unsigned int i = 0; i < threads; ++i) s.workers.emplace_back(workerLoop);
+	LOG_S(INFO) << "Texture loader started with " << threads << " decoding threads";
+  }
+
+  /**
+   * @brief stops workers and drops textures that weren't uploaded, call it before context is destroyed
+   */
+  static void stop() {
+	auto &s = state();
+	{
+	  std::lock_guard<std::mutex> lock(s.mutex);
+	  if (!s.running) return;
+	  s.running = false;
+	}
+	s.jobAdded.notify_all();
+	for (auto &worker : s.workers) worker.join();
+	s.workers.clear();
+	for (auto &image : s.decoded) stbi_image_free(image.pixels);
+	s.decoded.clear();
+	s.jobs.clear();
+	s.pending.clear();
+	glDeleteBuffers(1, &s.pixelBuffer);
+	s.pixelBuffer = 0;
+	Texture::placeholder() = 0;
+  }
+
+  [[nodiscard]] static bool isRunning() {
+	return state().running;
+  }
+
+  /**
+   * @brief creates texture and queues its image for decoding, needs GL context
+   */
+  static Texture *load(const std::string &filepath, TextureSampler sampler = {}) {
+	auto &s = state();
+	auto *texture = new Texture(filepath, sampler, Texture::Deferred{});
+	{
+	  std::lock_guard<std::mutex> lock(s.mutex);
+	  uint64_t id = s.nextId++;
+	  s.pending[texture] = id;
+	  s.jobs.push_back({texture, id});
+	}
+	s.jobAdded.notify_one();
+	return texture;
+  }
+
+  /**
+   * @brief forgets texture that is going to be deleted before it was uploaded
+   */
+  static void cancel(const Texture *texture) {
+	auto &s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	s.pending.erase(texture);
+  }
+
+  /**
+   * @brief uploads decoded textures, call it from GL thread once per frame
+   * @param budget milliseconds after which remaining textures wait for next call, at least one is uploaded
+   * @return amount of uploaded textures
+   */
+  static int poll(double budget = 2) {
+	auto &s = state();
+	if (!s.running) return 0;
+	CPU_PROFILE_ZONE("TextureLoader::poll");
+	auto start = CpuProfiler::now();
+	int uploaded = 0;
+	while ((double)(CpuProfiler::now() - start) / 1e6 < budget || uploaded == 0) {
+	  Decoded image{};
+	  {
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (s.decoded.empty()) break;
+		image = s.decoded.front();
+		s.decoded.pop_front();
+		auto pending = s.pending.find(image.texture);
+		if (pending == s.pending.end() || pending->second != image.id) {
+		  stbi_image_free(image.pixels);// texture was deleted meanwhile
+		  continue;
+		}
+		s.pending.erase(pending);
+	  }
+	  if (image.pixels == nullptr && image.cooked == nullptr) {
+		LOG_S(WARNING) << "Failed to load texture at " << image.texture->getFilepath();
+		continue;
+	  }
+	  upload(image);
+	  stbi_image_free(image.pixels);
+	  uploaded++;
+	}
+	return uploaded;
+  }
+
+  /**
+   * @brief blocks until every queued texture is uploaded, for runs that have to render final images
+   */
+  static void finish() {
+	auto &s = state();
+	if (!s.running) return;
+	CPU_PROFILE_ZONE("TextureLoader::finish");
+	while (true) {
+	  {
+		std::unique_lock<std::mutex> lock(s.mutex);
+		if (s.pending.empty()) return;
+		s.jobDecoded.wait(lock, [&s] { return !s.decoded.empty(); });
+	  }
+	  poll(std::numeric_limits<double>::infinity());
+	}
+  }
+
+  /**
+   * @brief amount of textures that are queued, decoding or waiting for upload
+   */
+  [[nodiscard]] static size_t getPending() {
+	auto &s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	return s.pending.size();
+  }
+
+ private:
+  static void workerLoop() {
+	auto &s = state();
+	while (true) {
+	  Job job{};
+	  std::string filepath;
+	  {
+		std::unique_lock<std::mutex> lock(s.mutex);
+		s.jobAdded.wait(lock, [&s] { return !s.jobs.empty() || !s.running; });
+		if (!s.running) return;
+		job = s.jobs.front();
+		s.jobs.pop_front();
+		auto pending = s.pending.find(job.texture);
+		if (pending == s.pending.end() || pending->second != job.id) continue;
+		filepath = job.texture->getFilepath();
+	  }
+	  Decoded image{job.texture, job.id, nullptr, 0, 0, 0, std::make_shared<KtxFile>()};
+	  if (!Texture::readCooked(filepath, *image.cooked)) {
+		image.cooked = nullptr;
+		image.pixels = Texture::decode(filepath, image.width, image.height, image.channels);
+	  }
+	  {
+		std::lock_guard<std::mutex> lock(s.mutex);
+		s.decoded.push_back(image);
+	  }
+	  s.jobDecoded.notify_all();
+	}
+  }
+
+  /**
+   * @brief copies pixels to the pixel buffer and lets driver transfer them to texture from there
+   */
+  static void upload(const Decoded &image) {
+	auto &s = state();
+	const unsigned char *pixels = image.cooked ? image.cooked->data.data() : image.pixels;
+	auto size = image.cooked ? (GLsizeiptr)image.cooked->data.size() : (GLsizeiptr)image.width * image.height * image.channels;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pixelBuffer);
+	// orphaning the previous storage lets driver keep transferring it while we fill a new one
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped != nullptr) {
+	  std::memcpy(mapped, pixels, size);
+	  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	  pixels = nullptr;// from now on offset in pixel buffer
+	} else {
+	  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	if (image.cooked) {
+	  image.texture->uploadCompressed(*image.cooked, pixels);
+	} else {
+	  image.texture->upload(pixels, image.width, image.height, image.channels);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+};
+
+#endif//CGCOURSEWORK_TEXTURE_LOADER_HPP
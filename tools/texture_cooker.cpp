@@ -0,0 +1,229 @@
+// Offline texture cooker: converts BMP/JPG/PNG/TGA images to block compressed KTX files with full mip chain.
+// Opaque images become BC1 (DXT1, 0.5 byte per pixel), images with alpha become BC3 (DXT5, 1 byte per pixel).
+// Images are flipped before compression, as OpenGL expects the bottom row first, so nothing is flipped at runtime.
+// Nothing here creates GL context or calls GL.
+// Usage: vlTextureCooker [--force] <directory or image>...
+
+#include <chrono>
+#include <glm/gtc/type_precision.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../libs/stb_image.h"
+#include "../functions.hpp"
+#include "../ktx_file.hpp"
+
+namespace {
+
+struct Image {
+  int width{0}, height{0};
+  std::vector<glm::u8vec4> pixels;
+
+  [[nodiscard]] const glm::u8vec4 &at(int x, int y) const {
+	return pixels[(size_t)std::min(y, height - 1) * width + std::min(x, width - 1)];
+  }
+};
+
+/**
+ * @brief halves image with 2x2 box filter, odd last row/column is dropped like glGenerateMipmap does
+ */
+Image downsample(const Image &image) {
+  Image result;
+  result.width = std::max(1, image.width / 2);
+  result.height = std::max(1, image.height / 2);
+  result.pixels.resize((size_t)result.width * result.height);
+  for (int y = 0; y < result.height; ++y) {
+	for (int x = 0; x < result.width; ++x) {
+	  glm::uvec4 sum{0};
+	  for (int dy = 0; dy < 2; ++dy) {
+		for (int dx = 0; dx < 2; ++dx) sum += glm::uvec4(image.at(x * 2 + dx, y * 2 + dy));
+	  }
+	  result.pixels[(size_t)y * result.width + x] = glm::u8vec4((sum + 2u) / 4u);
+	}
+  }
+  return result;
+}
+
+uint16_t to565(glm::vec3 color) {
+  auto r = (uint16_t)std::lround(glm::clamp(color.r, 0.f, 255.f) * 31 / 255);
+  auto g = (uint16_t)std::lround(glm::clamp(color.g, 0.f, 255.f) * 63 / 255);
+  auto b = (uint16_t)std::lround(glm::clamp(color.b, 0.f, 255.f) * 31 / 255);
+  return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+glm::vec3 from565(uint16_t color) {
+  return {(float)(color >> 11 & 31) * 255 / 31, (float)(color >> 5 & 63) * 255 / 63, (float)(color & 31) * 255 / 31};
+}
+
+/**
+ * @brief BC1 color block: endpoints are extremes of the block along its principal axis
+ */
+void encodeColorBlock(const glm::u8vec4 block[16], unsigned char *out) {
+  glm::vec3 mean{0};
+  for (int i = 0; i < 16; ++i) mean += glm::vec3(block[i]) / 16.f;
+  glm::mat3 covariance{0};
+  for (int i = 0; i < 16; ++i) {
+	glm::vec3 d = glm::vec3(block[i]) - mean;
+	covariance += glm::outerProduct(d, d);
+  }
+  glm::vec3 axis{1, 1, 1};
+  for (int i = 0; i < 8; ++i) {
+	axis = covariance * axis;
+	float length = glm::length(axis);
+	if (length < 1e-6f) break;
+	axis /= length;
+  }
+  if (!(glm::length(axis) > 1e-6f)) axis = glm::normalize(glm::vec3(1, 1, 1));
+  float minProjection = INFINITY, maxProjection = -INFINITY;
+  for (int i = 0; i < 16; ++i) {
+	float projection = glm::dot(glm::vec3(block[i]) - mean, axis);
+	minProjection = std::min(minProjection, projection);
+	maxProjection = std::max(maxProjection, projection);
+  }
+  uint16_t color0 = to565(mean + axis * maxProjection), color1 = to565(mean + axis * minProjection);
+  if (color0 < color1) std::swap(color0, color1);
+  glm::vec3 palette[4]{from565(color0), from565(color1)};
+  palette[2] = (palette[0] * 2.f + palette[1]) / 3.f;
+  palette[3] = (palette[0] + palette[1] * 2.f) / 3.f;
+  uint32_t indices = 0;
+  if (color0 != color1) {// equal endpoints would switch block to 3 color mode, index 0 is right for all pixels then
+	for (int i = 0; i < 16; ++i) {
+	  int best = 0;
+	  float bestDistance = INFINITY;
+	  for (int j = 0; j < 4; ++j) {
+		glm::vec3 d = glm::vec3(block[i]) - palette[j];
+		float distance = glm::dot(d, d);
+		if (distance < bestDistance) bestDistance = distance, best = j;
+	  }
+	  indices |= (uint32_t)best << (i * 2);
+	}
+  }
+  std::memcpy(out, &color0, 2);
+  std::memcpy(out + 2, &color1, 2);
+  std::memcpy(out + 4, &indices, 4);
+}
+
+/**
+ * @brief BC3 alpha block in 8 value mode between block's min and max alpha
+ */
+void encodeAlphaBlock(const glm::u8vec4 block[16], unsigned char *out) {
+  unsigned char alpha0 = 0, alpha1 = 255;
+  for (int i = 0; i < 16; ++i) {
+	alpha0 = std::max(alpha0, block[i].a);
+	alpha1 = std::min(alpha1, block[i].a);
+  }
+  uint64_t indices = 0;
+  if (alpha0 != alpha1) {
+	float palette[8]{(float)alpha0, (float)alpha1};
+	for (int j = 1; j < 7; ++j) palette[j + 1] = (float)((7 - j) * alpha0 + j * alpha1) / 7.f;
+	for (int i = 0; i < 16; ++i) {
+	  int best = 0;
+	  for (int j = 1; j < 8; ++j) {
+		if (std::abs(palette[j] - (float)block[i].a) < std::abs(palette[best] - (float)block[i].a)) best = j;
+	  }
+	  indices |= (uint64_t)best << (i * 3);
+	}
+  }
+  out[0] = alpha0;
+  out[1] = alpha1;
+  for (int i = 0; i < 6; ++i) out[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+void compressLevel(const Image &image, GLenum format, KtxFile &ktx) {
+  size_t blockSize = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+  size_t offset = ktx.data.size();
+  ktx.data.resize(offset + KtxFile::levelSize(format, image.width, image.height));
+  ktx.levels.push_back({image.width, image.height, offset, ktx.data.size() - offset});
+  unsigned char *out = ktx.data.data() + offset;
+  for (int by = 0; by < image.height; by += 4) {
+	for (int bx = 0; bx < image.width; bx += 4) {
+	  glm::u8vec4 block[16];
+	  for (int i = 0; i < 16; ++i) block[i] = image.at(bx + i % 4, by + i / 4);// edge pixels repeat in partial blocks
+	  if (blockSize == 16) encodeAlphaBlock(block, out);
+	  encodeColorBlock(block, out + blockSize - 8);
+	  out += blockSize;
+	}
+  }
+}
+
+/**
+ * @return false if image can't be read or cooked file written
+ */
+bool cook(const std::filesystem::path &source) {
+  int width, height, channels;
+  stbi_set_flip_vertically_on_load(1);
+  unsigned char *data = stbi_load(source.string().c_str(), &width, &height, &channels, 4);
+  if (data == nullptr) {
+	LOG_S(ERROR) << "Unable to read " << source.string() << ": " << stbi_failure_reason();
+	return false;
+  }
+  Image image;
+  image.width = width;
+  image.height = height;
+  image.pixels.assign((glm::u8vec4 *)data, (glm::u8vec4 *)data + (size_t)width * height);
+  stbi_image_free(data);
+  bool hasAlpha = std::any_of(image.pixels.begin(), image.pixels.end(), [](const glm::u8vec4 &pixel) { return pixel.a != 255; });
+
+  KtxFile ktx;
+  ktx.internalFormat = hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  ktx.width = width;
+  ktx.height = height;
+  while (true) {
+	compressLevel(image, ktx.internalFormat, ktx);
+	if (image.width == 1 && image.height == 1) break;
+	image = downsample(image);
+  }
+  std::string destination = KtxFile::cookedPath(source.string());
+  if (!ktx.write(destination)) {
+	LOG_S(ERROR) << "Unable to write " << destination;
+	return false;
+  }
+  LOG_S(INFO) << source.string() << " -> " << destination << " (" << (hasAlpha ? "BC3" : "BC1") << ", " << width << "x" << height
+			   << ", " << ktx.levels.size() << " levels, " << ktx.data.size() / 1024 << " KiB)";
+  return true;
+}
+
+bool isImage(const std::filesystem::path &path) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  return extension == ".bmp" || extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".tga";
+}
+
+}// namespace
+
+int main(int argc, char *argv[]) {
+  loguru::init(argc, argv);
+  bool force = false;
+  std::vector<std::filesystem::path> images;
+  for (int i = 1; i < argc; ++i) {
+	std::string argument = argv[i];
+	if (argument == "--force") {
+	  force = true;
+	} else if (std::filesystem::is_directory(argument)) {
+	  for (auto &entry : std::filesystem::recursive_directory_iterator(argument)) {
+		if (entry.is_regular_file() && isImage(entry.path())) images.push_back(entry.path());
+	  }
+	} else {
+	  images.emplace_back(argument);
+	}
+  }
+  if (images.empty()) {
+	LOG_S(ERROR) << "Usage: vlTextureCooker [--force] <directory or image>...";
+	return EXIT_FAILURE;
+  }
+  std::sort(images.begin(), images.end());
+
+  auto start = std::chrono::steady_clock::now();
+  int cooked = 0, skipped = 0, failed = 0;
+  for (auto &image : images) {
+	if (!force && KtxFile::isUpToDate(image.string())) {
+	  skipped++;
+	} else if (cook(image)) {
+	  cooked++;
+	} else {
+	  failed++;
+	}
+  }
+  LOG_S(INFO) << "Cooked " << cooked << " textures, " << skipped << " up to date, " << failed << " failed in "
+			   << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s";
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
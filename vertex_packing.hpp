@@ -0,0 +1,74 @@
+#ifndef CGCOURSEWORK_VERTEX_PACKING_HPP
+#define CGCOURSEWORK_VERTEX_PACKING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+/**
+ * @brief converts float vertex attributes to compact GPU formats
+ * @details normals become GL_INT_2_10_10_10_REV (4 bytes instead of 12), texture coordinates 16 bit normalized
+ * integers or GL_HALF_FLOAT when they tile (4 bytes instead of 8) and positions 16 bit normalized integers
+ * (8 bytes instead of 12) that are turned back to object space by a matrix applied before the model matrix.
+ */
+class VertexPacking {
+ public:
+  /**
+   * @param normals 3 floats per vertex
+   * @return 10 bits signed normalized per component, x in lowest bits
+   */
+  static std::vector<uint32_t> packNormals(const std::vector<float> &normals) {
+	std::vector<uint32_t> packed(normals.size() / 3);
+	auto component = [](float value) { return (uint32_t)((int32_t)std::round(glm::clamp(value, -1.f, 1.f) * 511.f) & 0x3FF); };
+	for (size_t i = 0; i < packed.size(); ++i) {
+	  packed[i] = component(normals[i * 3]) | component(normals[i * 3 + 1]) << 10 | component(normals[i * 3 + 2]) << 20;
+	}
+	return packed;
+  }
+
+  /**
+   * @param texCoords 2 floats per vertex
+   * @param normalized set to true when coordinates are 16 bit normalized integers, false when they are half floats
+   * @return both coordinates in 4 bytes, u in lowest bits. Coordinates within [0, 1] are stored as normalized
+   * integers, which are 32 times more precise than half floats there, tiling ones as half floats
+   */
+  static std::vector<uint32_t> packTexCoords(const std::vector<float> &texCoords, bool &normalized) {
+	normalized = std::all_of(texCoords.begin(), texCoords.end(), [](float value) { return value >= 0.f && value <= 1.f; });
+	std::vector<uint32_t> packed(texCoords.size() / 2);
+	for (size_t i = 0; i < packed.size(); ++i) {
+	  glm::vec2 uv{texCoords[i * 2], texCoords[i * 2 + 1]};
+	  packed[i] = normalized ? (uint32_t)std::round(uv.x * 65535.f) | (uint32_t)std::round(uv.y * 65535.f) << 16 : glm::packHalf2x16(uv);
+	}
+	return packed;
+  }
+
+  /**
+   * @brief maps positions to 16 bit integers over their bounding cube, 4th component is 1 as for any position
+   * @param positions 3 floats per vertex
+   * @param dequantization set to matrix that turns normalized [0, 1] positions back to original ones,
+   * scale is the same along all axes so normals stay right under it
+   */
+  static std::vector<uint16_t> quantizePositions(const std::vector<float> &positions, glm::mat4 &dequantization) {
+	glm::vec3 min{INFINITY}, max{-INFINITY};
+	for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+	  glm::vec3 position{positions[i], positions[i + 1], positions[i + 2]};
+	  min = glm::min(min, position);
+	  max = glm::max(max, position);
+	}
+	float extent = std::max({max.x - min.x, max.y - min.y, max.z - min.z, 1e-6f});
+	dequantization = glm::scale(glm::translate(glm::mat4(1.f), min), glm::vec3(extent));
+	std::vector<uint16_t> quantized(positions.size() / 3 * 4, 65535);// w of missing component would be 1 too, some drivers read it anyway
+	for (size_t i = 0; i < positions.size() / 3; ++i) {
+	  for (int j = 0; j < 3; ++j) {
+		quantized[i * 4 + j] = (uint16_t)std::round(glm::clamp((positions[i * 3 + j] - min[j]) / extent, 0.f, 1.f) * 65535.f);
+	  }
+	}
+	return quantized;
+  }
+};
+
+#endif//CGCOURSEWORK_VERTEX_PACKING_HPP
@@ -4,11 +4,16 @@
 
 #ifndef CGLABS__WINDOW_HPP_
 #define CGLABS__WINDOW_HPP_
+#include "Buffers/frame_buffer.hpp"
 #include "functions.hpp"
+#include "render_stats.hpp"
 class Window {
  private:
   GLFWwindow *window= nullptr; ///< reference to glfw window
   glm::vec2 windowSize{};
+  bool headless{false}; ///< whether window is hidden and scene is rendered to offscreenTarget
+  FrameBuffer *offscreenTarget{nullptr}; ///< render target used in headless mode
+  bool logStats{false}; ///< whether render statistics summary is also written to log
 
  public:
   /**
@@ -25,13 +30,32 @@ class Window {
   [[nodiscard]] GLFWwindow *getGLFWWindow() const {
 	return window;
   }
+  /**
+   * @brief whether window renders offscreen
+   * @return true if headless, false otherwise
+   */
+  [[nodiscard]] bool isHeadless() const {
+	return headless;
+  }
+  /**
+   * @brief returns offscreen render target
+   * @return FrameBuffer* or nullptr if window is not headless
+   */
+  [[nodiscard]] FrameBuffer *getFrameBuffer() const {
+	return offscreenTarget;
+  }
 
   /**
    * @brief init for window class
    * @param size vec2<int>window size
+   * @param _headless create hidden window and render into FrameBuffer instead
    */
-  explicit Window(glm::vec2 size) {
+  explicit Window(glm::vec2 size, bool _headless = false) {
 	windowSize = size;
+#if defined(VL_HEADLESS)
+	_headless = true;// GLFW was built with OSMesa backend, there is nothing to show
+#endif
+	headless = _headless;
 	// GLFW lib init
 	glfwSetErrorCallback(glfwErrorHandler);
 	if (!glfwInit()) {
@@ -46,21 +70,36 @@ class Window {
 	  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	  LOG_S(INFO) << "System: MacOS";
 	}
-	glfwWindowHint(GLFW_FLOATING, GL_TRUE);
-	glfwWindowHint(GLFW_FOCUS_ON_SHOW, GL_TRUE);
+	if (headless) {
+	  glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	  LOG_S(INFO) << "Mode: headless";
+	} else {
+	  glfwWindowHint(GLFW_FLOATING, GL_TRUE);
+	  glfwWindowHint(GLFW_FOCUS_ON_SHOW, GL_TRUE);
+	}
+#if !defined(NDEBUG)
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);// driver reports more through KHR_debug in debug context
+#endif
 	// GLFW Window creation
 	bruteforceGLVersion();
-	glfwMakeContextCurrent(window);
-	// tell GLFW to capture our mouse
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	if (window == nullptr) {
 	  LOG_S(FATAL) << "GLFW was unable to create window";
 	  glfwTerminate();
+	  throw std::runtime_error("Failed to create window");
+	}
+	glfwMakeContextCurrent(window);
+	// tell GLFW to capture our mouse
+	if (!headless) {
+	  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	}
 	// GLAD lib init
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 	  LOG_S(FATAL) << "GLAD init Failed";
 	}
+	if (headless) {
+	  offscreenTarget = new FrameBuffer(windowSize);
+	}
 
 	GLint maxShaderTextures;
 	GLint maxTotalTextures;
@@ -78,23 +117,48 @@ class Window {
 	  LOG_S(ERROR) << "GLFW error: " << error << " " << message;
   }
   ~Window() {
+	delete offscreenTarget;
 	glfwDestroyWindow(window);
 	LOG_S(INFO) << "GLFW window destroyed";
 	LOG_S(INFO) << "Window(" << this << ") destroyed";
   }
+  /**
+   * @brief reads back what was rendered this frame, call before swapping buffers
+   * @return RGBA8 pixels, bottom row first
+   */
+  [[nodiscard]] std::vector<unsigned char> readPixels() const {
+	if (offscreenTarget != nullptr) {
+	  return offscreenTarget->readPixels();
+	}
+	std::vector<unsigned char> pixels((size_t)windowSize.x * (size_t)windowSize.y * 4);
+	glCall(glReadBuffer(GL_BACK));
+	glCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	glCall(glReadPixels(0, 0, (GLsizei)windowSize.x, (GLsizei)windowSize.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	return pixels;
+  }
+  /**
+   * @brief enables writing render statistics summary to log (once a second)
+   * @param enable
+   */
+  void setStatsLogging(bool enable) {
+	logStats = enable;
+  }
+  /**
+   * @brief shows render statistics of last frame and recent frame times in window title (and log if enabled)
+   */
   [[maybe_unused]] void updateFpsCounter() {
 	static double previous_seconds = glfwGetTime();
-	static int frame_count;
+	static double previous_log_seconds = glfwGetTime();
 	double current_seconds = glfwGetTime();
-	double elapsed_seconds = current_seconds - previous_seconds;
-	if (elapsed_seconds > 0.25) {
+	if (current_seconds - previous_seconds > 0.25) {
 	  previous_seconds = current_seconds;
-	  double fps       = (double)frame_count / elapsed_seconds;
-	  std::string tmp  =  "Marcusessssss courseWork @ fps: " + std::to_string(fps);
+	  std::string tmp  =  "Marcusessssss courseWork @ " + RenderStats::summary();
 	  glfwSetWindowTitle(window, tmp.c_str());
-	  frame_count = 0;
 	}
-	frame_count++;
+	if (logStats && current_seconds - previous_log_seconds > 1.0) {
+	  previous_log_seconds = current_seconds;
+	  LOG_S(INFO) << RenderStats::summary();
+	}
   }
  private:
   /**